@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <json.hpp>
+#include <dsp/bench/speed_tester.h>
+#include <dsp/filter/fir.h>
+#include <dsp/filter/decimating_fir.h>
+#include <dsp/filter/fft_fir.h>
+#include <dsp/multirate/power_decimator.h>
+#include <dsp/multirate/rational_resampler.h>
+#include <dsp/channel/rx_vfo.h>
+#include <dsp/demod/quadrature.h>
+#include <dsp/demod/broadcast_fm.h>
+#include <dsp/demod/psk.h>
+#include <dsp/loop/agc.h>
+#include <dsp/clock_recovery/mm.h>
+#include <dsp/noise_reduction/fm_if.h>
+#include <dsp/noise_reduction/fm_if_fft.h>
+#include <dsp/routing/splitter.h>
+#include <dsp/sink/null_sink.h>
+#include <dsp/compression/sample_stream_compressor.h>
+#include <dsp/taps/windowed_sinc.h>
+
+using nlohmann::json;
+
+#define BENCH_DEFAULT_DURATION_MS   500
+#define BENCH_SAMPLERATE            1000000.0
+
+// Number of outputs the splitter is benchmarked with
+#define BENCH_SPLITTER_OUTPUTS      4
+
+enum OutputFormat {
+    OUTPUT_FORMAT_TEXT,
+    OUTPUT_FORMAT_CSV,
+    OUTPUT_FORMAT_JSON
+};
+
+struct Benchmark {
+    std::string name;
+    // Name of the parameter swept on top of the buffer size, empty if there is none
+    std::string paramName;
+    std::vector<int> params;
+    // Returns the input rate in samples per second
+    std::function<double(int param, int bufferSize)> run;
+};
+
+struct Result {
+    std::string name;
+    std::string paramName;
+    int param;
+    int bufferSize;
+    double rate;
+};
+
+const int bufferSizes[] = { 512, 2048, 8192, 32768 };
+const std::vector<int> tapCounts = { 16, 64, 256 };
+int durationMs = BENCH_DEFAULT_DURATION_MS;
+
+// Feed the block with random samples while draining its output
+template <class I, class O>
+double measure(dsp::block& block, dsp::stream<I>* in, dsp::stream<O>* out, int bufferSize) {
+    dsp::bench::SpeedTester<I, O> tester(in, out);
+    block.start();
+    double rate = tester.benchmark(durationMs, bufferSize);
+    block.stop();
+    return rate;
+}
+
+dsp::tap<float> lowPassTaps(int count) {
+    return dsp::taps::windowedSinc<float>(count, 100000.0, BENCH_SAMPLERATE, dsp::window::nuttall);
+}
+
+template <class BLOCK>
+double benchFIR(int tapCount, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::tap<float> taps = lowPassTaps(tapCount);
+    BLOCK block(&in, taps);
+    double rate = measure(block, &in, &block.out, bufferSize);
+    dsp::taps::free(taps);
+    return rate;
+}
+
+double benchDecimatingFIR(int tapCount, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::tap<float> taps = lowPassTaps(tapCount);
+    dsp::filter::DecimatingFIR<dsp::complex_t, float> block(&in, taps, 4);
+    double rate = measure(block, &in, &block.out, bufferSize);
+    dsp::taps::free(taps);
+    return rate;
+}
+
+double benchPowerDecimator(int ratio, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::multirate::PowerDecimator<dsp::complex_t> block(&in, ratio);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+double benchRationalResampler(int param, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::multirate::RationalResampler<dsp::complex_t> block(&in, BENCH_SAMPLERATE, 48000.0);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+double benchRxVFO(int param, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::channel::RxVFO block(&in, BENCH_SAMPLERATE, 250000.0, 200000.0, 100000.0);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+double benchQuadrature(int param, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::demod::Quadrature block(&in, 75000.0, 250000.0);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+double benchBroadcastFM(int param, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::demod::BroadcastFM block(&in, 75000.0, 250000.0, true, true);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+double benchAGC(int param, int bufferSize) {
+    dsp::stream<float> in;
+    dsp::loop::AGC<float> block(&in, 1.0, 1e-3, 1e-4, 10e6, 10.0);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+double benchMM(int param, int bufferSize) {
+    dsp::stream<float> in;
+    dsp::clock_recovery::MM<float> block(&in, 10.0, 1e-6, 0.01, 0.01);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+double benchPSK(int param, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::demod::PSK<4> block(&in, 18000.0, 72000.0, 31, 0.6, 0.02, 0.01, 1e-6, 0.01);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+template <class BLOCK>
+double benchFMIF(int bins, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    BLOCK block(&in, bins);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+double benchSplitter(int shared, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::routing::Splitter<dsp::complex_t> block(&in);
+    block.setShared(shared);
+
+    // The first output is read by the tester, the others by null sinks
+    dsp::stream<dsp::complex_t> outs[BENCH_SPLITTER_OUTPUTS];
+    dsp::sink::Null<dsp::complex_t> sinks[BENCH_SPLITTER_OUTPUTS - 1];
+    for (int i = 0; i < BENCH_SPLITTER_OUTPUTS; i++) {
+        block.bindStream(&outs[i]);
+        if (i) {
+            sinks[i - 1].init(&outs[i]);
+            sinks[i - 1].start();
+        }
+    }
+
+    double rate = measure(block, &in, &outs[0], bufferSize);
+    for (auto& sink : sinks) { sink.stop(); }
+    return rate;
+}
+
+double benchCompressor(int pcmType, int bufferSize) {
+    dsp::stream<dsp::complex_t> in;
+    dsp::compression::SampleStreamCompressor block(&in, (dsp::compression::PCMType)pcmType);
+    return measure(block, &in, &block.out, bufferSize);
+}
+
+void printUsage(const char* name) {
+    printf("Usage: %s [--csv | --json] [--duration ms] [--filter name]\n", name);
+    printf("  --csv          Output results as CSV\n");
+    printf("  --json         Output results as JSON\n");
+    printf("  --duration ms  Duration of each measurement (default %d)\n", BENCH_DEFAULT_DURATION_MS);
+    printf("  --filter name  Only run the benchmarks whose name contains this string\n");
+}
+
+int main(int argc, char* argv[]) {
+    OutputFormat format = OUTPUT_FORMAT_TEXT;
+    std::string filter;
+
+    // Parse arguments
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--csv")) {
+            format = OUTPUT_FORMAT_CSV;
+        }
+        else if (!strcmp(argv[i], "--json")) {
+            format = OUTPUT_FORMAT_JSON;
+        }
+        else if (!strcmp(argv[i], "--duration") && i + 1 < argc) {
+            durationMs = std::max<int>(atoi(argv[++i]), 1);
+        }
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else {
+            printUsage(argv[0]);
+            return (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) ? 0 : -1;
+        }
+    }
+
+    std::vector<Benchmark> benchmarks = {
+        { "FIR", "taps", tapCounts, benchFIR<dsp::filter::FIR<dsp::complex_t, float>> },
+        { "FFTFIR", "taps", tapCounts, benchFIR<dsp::filter::FFTFIR<dsp::complex_t, float>> },
+        { "DecimatingFIR", "taps", tapCounts, benchDecimatingFIR },
+        { "PowerDecimator", "ratio", { 2, 8, 32 }, benchPowerDecimator },
+        { "RationalResampler", "", { 0 }, benchRationalResampler },
+        { "RxVFO", "", { 0 }, benchRxVFO },
+        { "Quadrature", "", { 0 }, benchQuadrature },
+        { "BroadcastFM", "", { 0 }, benchBroadcastFM },
+        { "AGC", "", { 0 }, benchAGC },
+        { "MM", "", { 0 }, benchMM },
+        { "PSK", "", { 0 }, benchPSK },
+        { "FMIF", "bins", { 8, 16, 32, 64 }, benchFMIF<dsp::noise_reduction::FMIF> },
+        { "FFTFMIF", "bins", { 8, 16, 32, 64 }, benchFMIF<dsp::noise_reduction::FFTFMIF> },
+        { "Splitter", "shared", { 0, 1 }, benchSplitter },
+        { "SampleStreamCompressor", "pcm_type", { dsp::compression::PCM_TYPE_I8, dsp::compression::PCM_TYPE_I16, dsp::compression::PCM_TYPE_F32 }, benchCompressor }
+    };
+
+    // Run everything that matches the filter
+    std::vector<Result> results;
+    if (format == OUTPUT_FORMAT_TEXT) {
+        printf("%-24s%-10s%-8s%-10s%-12s%s\n", "block", "param", "value", "buffer", "MS/s", "ns/sample");
+    }
+    else if (format == OUTPUT_FORMAT_CSV) {
+        printf("block,param,value,buffer_size,msps,ns_per_sample\n");
+    }
+    for (auto& bench : benchmarks) {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos) { continue; }
+        for (int param : bench.params) {
+            for (int bufferSize : bufferSizes) {
+                Result res = { bench.name, bench.paramName, param, bufferSize, bench.run(param, bufferSize) };
+                results.push_back(res);
+
+                // Print as we go except for JSON which is printed in one piece at the end
+                double msps = res.rate / 1e6;
+                double ns = (res.rate > 0.0) ? (1e9 / res.rate) : 0.0;
+                if (format == OUTPUT_FORMAT_TEXT) {
+                    printf("%-24s%-10s%-8d%-10d%-12.3lf%.2lf\n", res.name.c_str(), res.paramName.c_str(), res.param, res.bufferSize, msps, ns);
+                    fflush(stdout);
+                }
+                else if (format == OUTPUT_FORMAT_CSV) {
+                    printf("%s,%s,%d,%d,%.3lf,%.2lf\n", res.name.c_str(), res.paramName.c_str(), res.param, res.bufferSize, msps, ns);
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+
+    if (format == OUTPUT_FORMAT_JSON) {
+        json out;
+        out["durationMs"] = durationMs;
+        out["results"] = json::array();
+        for (auto& res : results) {
+            json r;
+            r["block"] = res.name;
+            r["param"] = res.paramName;
+            r["value"] = res.param;
+            r["bufferSize"] = res.bufferSize;
+            r["msps"] = res.rate / 1e6;
+            r["nsPerSample"] = (res.rate > 0.0) ? (1e9 / res.rate) : 0.0;
+            out["results"].push_back(r);
+        }
+        printf("%s\n", out.dump(4).c_str());
+    }
+
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include "imgui_impl_opengl3.h"
 #include <GLFW/glfw3.h>
 #include <utils/flog.h>
+#include <utils/trace.h>
 #include <utils/opengl_include_code.h>
 #include <version.h>
 #include <core.h>
@@ -209,6 +210,7 @@ namespace backend {
     }
 
     void render(bool vsync) {
+        TRACE_SCOPE("render");
         // Rendering
         ImGui::Render();
         int display_w, display_h;
@@ -233,8 +235,11 @@ namespace backend {
     }
 
     int renderLoop() {
+        TRACE_THREAD_NAME("Render");
+
         // Main loop
         while (!glfwWindowShouldClose(window)) {
+            TRACE_SCOPE("frame");
             glfwPollEvents();
 
             beginFrame();
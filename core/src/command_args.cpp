@@ -19,6 +19,10 @@ void CommandArgsParser::defineAll() {
         define('r', "root", "Root directory, where all config files are stored", std::filesystem::absolute(root).string());
         define('s', "server", "Run in server mode");
         define('\0', "autostart", "Automatically start the SDR after loading");
+        define('\0', "headless", "Run without GUI, configured from this JSON file", "");
+#ifdef SDRPP_TRACING
+        define('\0', "trace", "Write a Chrome trace of the DSP and render threads to this file on exit", "");
+#endif
 }
 
 int CommandArgsParser::parse(int argc, char* argv[]) {
@@ -1,4 +1,5 @@
 #include <server.h>
+#include <headless.h>
 #include "imgui.h"
 #include <stdio.h>
 #include <gui/main_window.h>
@@ -7,6 +8,8 @@
 #include <gui/icons.h>
 #include <version.h>
 #include <utils/flog.h>
+#include <utils/fft_plan.h>
+#include <utils/trace.h>
 #include <gui/widgets/bandplan.h>
 #include <stb_image.h>
 #include <config.h>
@@ -78,10 +81,12 @@ int sdrpp_main(int argc, char* argv[]) {
     }
 
     bool serverMode = (bool)core::args["server"];
+    std::string headlessConfig = (std::string)core::args["headless"];
+    bool headlessMode = !headlessConfig.empty();
 
 #ifdef _WIN32
-    // Free console if the user hasn't asked for a console and not in server mode
-    if (!core::args["con"].b() && !serverMode) { FreeConsole(); }
+    // Free console if the user hasn't asked for a console and not in server or headless mode
+    if (!core::args["con"].b() && !serverMode && !headlessMode) { FreeConsole(); }
 
     // Set error mode to avoid abnoxious popups
     SetErrorMode(SEM_NOOPENFILEERRORBOX | SEM_NOGPFAULTERRORBOX | SEM_FAILCRITICALERRORS);
@@ -103,6 +108,15 @@ int sdrpp_main(int argc, char* argv[]) {
         return -1;
     }
 
+#ifdef SDRPP_TRACING
+    // Record trace events until exit if requested
+    std::string tracePath = (std::string)core::args["trace"];
+    if (!tracePath.empty()) {
+        flog::info("Tracing enabled, events will be written to {0}", tracePath);
+        trace::start();
+    }
+#endif
+
     // ======== DEFAULT CONFIG ========
     json defConfig;
     defConfig["bandColors"]["amateur"] = "#FF0000FF";
@@ -159,6 +173,9 @@ int sdrpp_main(int argc, char* argv[]) {
     defConfig["menuElements"][7]["name"] = "Display";
     defConfig["menuElements"][7]["open"] = true;
 
+    defConfig["menuElements"][8]["name"] = "DSP Profiler";
+    defConfig["menuElements"][8]["open"] = false;
+
     defConfig["menuWidth"] = 300;
     defConfig["min"] = -120.0;
 
@@ -249,6 +266,8 @@ int sdrpp_main(int argc, char* argv[]) {
     defConfig["decimation"] = 1;
     defConfig["iqCorrection"] = false;
     defConfig["invertIQ"] = false;
+    defConfig["channelizer"] = false;
+    defConfig["dspScheduler"] = false;
 
     defConfig["streams"]["Radio"]["muted"] = false;
     defConfig["streams"]["Radio"]["sink"] = "Audio";
@@ -355,7 +374,11 @@ int sdrpp_main(int argc, char* argv[]) {
 
     core::configManager.release(true);
 
+    // Load the FFT plans measured during previous runs
+    fftplan::init(root + "/fftw_wisdom.dat");
+
     if (serverMode) { return server::main(); }
+    if (headlessMode) { return headless::main(headlessConfig); }
 
     core::configManager.acquire();
     std::string resDir = core::configManager.conf["resourcesDirectory"];
@@ -411,8 +434,17 @@ int sdrpp_main(int argc, char* argv[]) {
 
     sigpath::iqFrontEnd.stop();
 
+    fftplan::end();
+
     core::configManager.disableAutoSave();
     core::configManager.save();
+
+#ifdef SDRPP_TRACING
+    if (!tracePath.empty()) {
+        trace::stop();
+        trace::dump(tracePath);
+    }
+#endif
 #endif
 
     flog::info("Exiting successfully");
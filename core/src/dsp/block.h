@@ -3,8 +3,13 @@
 #include <thread>
 #include <vector>
 #include <algorithm>
+#include <string>
+#include <typeinfo>
 #include "stream.h"
 #include "types.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "../utils/trace.h"
 
 namespace dsp {
     class generic_block {
@@ -13,11 +18,17 @@ namespace dsp {
         virtual void start() {}
         virtual void stop() {}
         virtual int run() { return -1; }
+        virtual void setScheduler(Scheduler* scheduler) {}
     };
 
     class block : public generic_block {
     public:
+        block() {
+            profiler::registerBlock(this);
+        }
+
         virtual ~block() {
+            profiler::unregisterBlock(this);
             if (!_block_init) { return; }
             stop();
             _block_init = false;
@@ -30,6 +41,17 @@ namespace dsp {
                 return;
             }
             running = true;
+
+            // The type can only be known once fully constructed
+            {
+                std::lock_guard<std::mutex> lck(nameMtx);
+                if (typeName.empty()) { typeName = typeid(*this).name(); }
+#ifdef SDRPP_TRACING
+                std::string traceStr = _name.empty() ? profiler::demangle(typeName) : _name;
+                strncpy(traceName, traceStr.c_str(), TRACE_NAME_SIZE - 1);
+#endif
+            }
+
             doStart();
         }
 
@@ -61,18 +83,106 @@ namespace dsp {
             }
         }
 
+        // Run the block as a task on a scheduler instead of on its own thread, NULL to go back to a thread
+        virtual void setScheduler(Scheduler* scheduler) {
+            assert(_block_init);
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            tempStop();
+            _scheduler = scheduler;
+            tempStart();
+        }
+
         virtual int run() = 0;
 
+        // Name shown by the profiler, the type of the block is used if none is set
+        void setName(std::string name) {
+            std::lock_guard<std::mutex> lck(nameMtx);
+            _name = name;
+        }
+
+        std::string getName() {
+            std::lock_guard<std::mutex> lck(nameMtx);
+            return _name;
+        }
+
+        // Mangled type name, empty if the block was never started
+        std::string getTypeName() {
+            std::lock_guard<std::mutex> lck(nameMtx);
+            return typeName;
+        }
+
+        bool isScheduled() {
+            return _scheduler != NULL;
+        }
+
+        profiler::Counters& getCounters() {
+            return counters;
+        }
+
+        friend Scheduler;
+
     protected:
         void workerLoop() {
-            while (run() >= 0) {}
+            profiler::setCurrent(&counters);
+            TRACE_THREAD_NAME(traceName);
+            cpuBase = counters.cpuNs;
+            while (profiledRun() >= 0) {}
+            profiler::setCurrent(NULL);
+        }
+
+        // Call run() and update the profiler counters
+        int profiledRun() {
+            TRACE_SCOPE(traceName);
+            if (!profiler::isEnabled()) { return run(); }
+
+            uint64_t start = profiler::now();
+            int count = run();
+            uint64_t end = profiler::now();
+            if (count < 0) { return count; }
+
+            counters.runs++;
+            counters.samples += count;
+            counters.runNs += end - start;
+
+            // Scheduled blocks never wait and share their thread. Reading the CPU time of a thread isn't
+            // free so blocks on their own thread only do it once in a while.
+            if (_scheduler) {
+                counters.cpuNs += end - start;
+            }
+            else if (end - counters.lastCpuSample >= PROFILER_CPU_SAMPLE_INTERVAL) {
+                counters.cpuNs = cpuBase + profiler::threadCpuTime();
+                counters.lastCpuSample = end;
+            }
+
+            return count;
         }
 
         virtual void doStart() {
+            if (_scheduler) {
+                for (auto& in : inputs) {
+                    in->setReaderTask(this);
+                }
+                for (auto& out : outputs) {
+                    out->setWriterTask(this);
+                }
+                _scheduler->add(this);
+                return;
+            }
             workerThread = std::thread(&block::workerLoop, this);
         }
 
         virtual void doStop() {
+            if (_scheduler) {
+                for (auto& in : inputs) {
+                    in->setReaderTask(NULL);
+                }
+                for (auto& out : outputs) {
+                    out->setWriterTask(NULL);
+                }
+                _scheduler->remove(this);
+                return;
+            }
+
             for (auto& in : inputs) {
                 in->stopReader();
             }
@@ -93,6 +203,17 @@ namespace dsp {
             }
         }
     
+        // True if run() can go through without blocking on any stream
+        bool schedReady() {
+            for (auto& in : inputs) {
+                if (!in->readable()) { return false; }
+            }
+            for (auto& out : outputs) {
+                if (!out->writable()) { return false; }
+            }
+            return true;
+        }
+
         void acquire() {
             ctrlMtx.lock();
         }
@@ -128,5 +249,16 @@ namespace dsp {
         bool tempStopped = false;
         int tempStopDepth = 0;
         std::thread workerThread;
+
+        Scheduler* _scheduler = NULL;
+
+        std::mutex nameMtx;
+        std::string _name;
+        std::string typeName;
+        profiler::Counters counters;
+        uint64_t cpuBase = 0;
+        char traceName[TRACE_NAME_SIZE] = "";
+        std::atomic<int> schedState = { 0 };
+        std::atomic<bool> schedEnabled = { false };
     };
 }
\ No newline at end of file
@@ -75,8 +75,7 @@ namespace dsp::buffer {
         }
 
         void loop() {
-            while (run() >= 0)
-                ;
+            base_type::workerLoop();
         }
 
         void doStop() override {
@@ -0,0 +1,88 @@
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include "buffer.h"
+
+namespace dsp::buffer {
+    // Pool of reference counted read-only buffers. A block is handed to several readers at once
+    // and goes back to the pool once all of them released it. The pool is owned by its creator
+    // until destroy() is called but only gets deleted once every outstanding block came back.
+    template <class T>
+    class SharedPool {
+    public:
+        struct Block {
+            T* data;
+            std::atomic<int> refs;
+            SharedPool<T>* pool;
+        };
+
+        static SharedPool<T>* create(int size) {
+            return new SharedPool<T>(size);
+        }
+
+        void destroy() {
+            std::unique_lock<std::mutex> lck(mtx);
+            for (auto& b : freeBlocks) { deleteBlock(b); }
+            freeBlocks.clear();
+            orphaned = true;
+            if (outstanding) { return; }
+            lck.unlock();
+            delete this;
+        }
+
+        // Get a free block that will be recycled after `readers` calls to release()
+        Block* acquire(int readers) {
+            std::lock_guard<std::mutex> lck(mtx);
+            Block* b;
+            if (freeBlocks.empty()) {
+                b = new Block;
+                b->data = alloc<T>(bufferSize);
+                b->pool = this;
+            }
+            else {
+                b = freeBlocks.back();
+                freeBlocks.pop_back();
+            }
+            b->refs = readers;
+            outstanding++;
+            return b;
+        }
+
+        static void release(Block* b) {
+            if (--b->refs) { return; }
+            b->pool->recycle(b);
+        }
+
+    private:
+        SharedPool(int size) {
+            bufferSize = size;
+        }
+
+        void recycle(Block* b) {
+            std::unique_lock<std::mutex> lck(mtx);
+            outstanding--;
+            if (!orphaned) {
+                freeBlocks.push_back(b);
+                return;
+            }
+
+            // The owner is gone, free the block and the pool once it was the last one
+            deleteBlock(b);
+            if (outstanding) { return; }
+            lck.unlock();
+            delete this;
+        }
+
+        static void deleteBlock(Block* b) {
+            buffer::free(b->data);
+            delete b;
+        }
+
+        std::mutex mtx;
+        std::vector<Block*> freeBlocks;
+        int outstanding = 0;
+        bool orphaned = false;
+        int bufferSize;
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include "buffer.h"
+
+namespace dsp::buffer {
+    // Lock-free ring buffer for exactly one writer thread and one reader thread. Neither side
+    // ever waits, they just get fewer samples than asked for when the ring is full or empty.
+    template <class T>
+    class SPSCRing {
+    public:
+        SPSCRing() {}
+
+        SPSCRing(int capacity) { init(capacity); }
+
+        ~SPSCRing() {
+            if (!_buffer) { return; }
+            buffer::free(_buffer);
+        }
+
+        // The capacity is rounded up to a power of two
+        void init(int capacity) {
+            if (_buffer) { buffer::free(_buffer); }
+            size = 1;
+            while (size < capacity) { size <<= 1; }
+            mask = size - 1;
+            _buffer = buffer::alloc<T>(size);
+            readc = 0;
+            writec = 0;
+        }
+
+        int write(const T* data, int len) {
+            uint64_t w = writec.load(std::memory_order_relaxed);
+            uint64_t r = readc.load(std::memory_order_acquire);
+            len = std::min<int>(len, size - (int)(w - r));
+
+            // Copy in up to two parts if wrapping around the end of the buffer
+            int start = w & mask;
+            int first = std::min<int>(len, size - start);
+            memcpy(&_buffer[start], data, first * sizeof(T));
+            memcpy(_buffer, &data[first], (len - first) * sizeof(T));
+
+            writec.store(w + len, std::memory_order_release);
+            return len;
+        }
+
+        int read(T* data, int len) {
+            uint64_t r = readc.load(std::memory_order_relaxed);
+            uint64_t w = writec.load(std::memory_order_acquire);
+            len = std::min<int>(len, (int)(w - r));
+
+            // Copy out in up to two parts if wrapping around the end of the buffer
+            int start = r & mask;
+            int first = std::min<int>(len, size - start);
+            memcpy(data, &_buffer[start], first * sizeof(T));
+            memcpy(&data[first], _buffer, (len - first) * sizeof(T));
+
+            readc.store(r + len, std::memory_order_release);
+            return len;
+        }
+
+        // Drop up to len samples, only to be called by the reader
+        int skip(int len) {
+            uint64_t r = readc.load(std::memory_order_relaxed);
+            uint64_t w = writec.load(std::memory_order_acquire);
+            len = std::min<int>(len, (int)(w - r));
+            readc.store(r + len, std::memory_order_release);
+            return len;
+        }
+
+        int getReadable() {
+            return (int)(writec.load(std::memory_order_acquire) - readc.load(std::memory_order_acquire));
+        }
+
+        int getWritable() {
+            return size - getReadable();
+        }
+
+        int getCapacity() {
+            return size;
+        }
+
+    private:
+        T* _buffer = NULL;
+        int size = 0;
+        int mask = 0;
+        std::atomic<uint64_t> readc = { 0 };
+        std::atomic<uint64_t> writec = { 0 };
+    };
+}
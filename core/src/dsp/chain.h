@@ -4,6 +4,42 @@
 #include "processor.h"
 
 namespace dsp {
+    // Runs the process() of the enabled blocks of a fused chain in order, in place, on a single thread
+    template<class T>
+    class FusedChainRunner : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        void setLinks(const std::vector<Processor<T, T>*>& links) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _links = links;
+            base_type::tempStart();
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Run the first block from the input buffer and the others in place
+            const T* data = base_type::_in->readBuf;
+            for (auto& ln : _links) {
+                count = ln->fusedProcess(count, data, base_type::out.writeBuf);
+                data = base_type::out.writeBuf;
+                if (!count) { break; }
+            }
+
+            base_type::_in->flush();
+            if (count) {
+                if (!base_type::out.swap(count)) { return -1; }
+            }
+            return count;
+        }
+
+    protected:
+        std::vector<Processor<T, T>*> _links;
+    };
+
     template<class T>
     class chain {
     public:
@@ -14,11 +50,23 @@ namespace dsp {
         void init(stream<T>* in) {
             _in = in;
             out = _in;
+
+            // The runner's buffers are only allocated when the chain is fused
+            runner.init(_in);
+            runner.out.free();
         }
 
         template<typename Func>
         void setInput(stream<T>* in, Func onOutputChange) {
             _in = in;
+            if (fused) {
+                runner.setInput(_in);
+                if (enabledLinks().empty()) {
+                    out = _in;
+                    onOutputChange(out);
+                }
+                return;
+            }
             for (auto& ln : links) {
                 if (states[ln]) {
                     ln->setInput(_in);
@@ -35,6 +83,11 @@ namespace dsp {
                 throw std::runtime_error("[chain] Tried to add a block that is already part of the chain");
             }
 
+            // Fused chains can only contain blocks that support it
+            if (fused && !block->fusable()) {
+                throw std::runtime_error("[chain] Tried to add a block that can't be fused to a fused chain");
+            }
+
             // Add to the list
             links.push_back(block);
             states[block] = false;
@@ -68,6 +121,13 @@ namespace dsp {
             // If already enable, don't do anything
             if (states[block]) { return; }
 
+            // When fused, only the list of blocks run by the runner needs to change
+            if (fused) {
+                states[block] = true;
+                updateRunner(onOutputChange);
+                return;
+            }
+
             // Gather blocks before and after the block to enable
             Processor<T, T>* before = blockBefore(block);
             Processor<T, T>* after = blockAfter(block);
@@ -99,6 +159,13 @@ namespace dsp {
             // If already disabled, don't do anything
             if (!states[block]) { return; }
 
+            // When fused, only the list of blocks run by the runner needs to change
+            if (fused) {
+                states[block] = false;
+                updateRunner(onOutputChange);
+                return;
+            }
+
             // Stop disabled block
             block->stop();
             states[block] = false;
@@ -141,8 +208,68 @@ namespace dsp {
             }
         }
 
+        // Run all enabled blocks on a single thread instead of one thread per block.
+        // Only possible if every block of the chain is fusable.
+        template<typename Func>
+        void setFused(bool enabled, Func onOutputChange) {
+            if (fused == enabled) { return; }
+
+            if (enabled) {
+                // Check that every block supports it
+                for (auto& ln : links) {
+                    if (!ln->fusable()) {
+                        throw std::runtime_error("[chain] Tried to fuse a chain containing a block that can't be fused");
+                    }
+                }
+
+                // Stop the individual blocks
+                if (running) {
+                    for (auto& ln : links) {
+                        if (!states[ln]) { continue; }
+                        ln->stop();
+                    }
+                }
+
+                // Hand them to the runner
+                runner.out.setBufferSize(STREAM_BUFFER_SIZE);
+                runner.setInput(_in);
+                fused = true;
+                updateRunner(onOutputChange);
+            }
+            else {
+                runner.stop();
+                fused = false;
+
+                // Reconnect the enabled blocks together
+                Processor<T, T>* last = NULL;
+                for (auto& ln : links) {
+                    if (!states[ln]) { continue; }
+                    ln->setInput(last ? &last->out : _in);
+                    last = ln;
+                }
+                out = last ? &last->out : _in;
+                onOutputChange(out);
+                runner.out.free();
+
+                // Restart the individual blocks
+                if (running) {
+                    for (auto& ln : links) {
+                        if (!states[ln]) { continue; }
+                        ln->start();
+                    }
+                }
+            }
+        }
+
+        inline bool isFused() { return fused; }
+
         void start() {
             if (running) { return; }
+            if (fused) {
+                if (!enabledLinks().empty()) { runner.start(); }
+                running = true;
+                return;
+            }
             for (auto& ln : links) {
                 if (!states[ln]) { continue; }
                 ln->start();
@@ -152,6 +279,11 @@ namespace dsp {
 
         void stop() {
             if (!running) { return; }
+            if (fused) {
+                runner.stop();
+                running = false;
+                return;
+            }
             for (auto& ln : links) {
                 if (!states[ln]) { continue; }
                 ln->stop();
@@ -187,9 +319,33 @@ namespace dsp {
             return states.find(block) != states.end();
         }
 
+        // Give the enabled blocks to the runner, the runner is bypassed if none are enabled
+        template<typename Func>
+        void updateRunner(Func onOutputChange) {
+            std::vector<Processor<T, T>*> enabled = enabledLinks();
+            runner.setLinks(enabled);
+            if (enabled.empty()) { runner.stop(); }
+            stream<T>* newOut = enabled.empty() ? _in : &runner.out;
+            if (newOut != out) {
+                out = newOut;
+                onOutputChange(out);
+            }
+            if (running && !enabled.empty()) { runner.start(); }
+        }
+
+        std::vector<Processor<T, T>*> enabledLinks() {
+            std::vector<Processor<T, T>*> enabled;
+            for (auto& ln : links) {
+                if (states[ln]) { enabled.push_back(ln); }
+            }
+            return enabled;
+        }
+
         stream<T>* _in;
         std::vector<Processor<T, T>*> links;
         std::map<Processor<T, T>*, bool> states;
         bool running = false;
+        bool fused = false;
+        FusedChainRunner<T> runner;
     };
 }
\ No newline at end of file
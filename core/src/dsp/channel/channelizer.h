@@ -0,0 +1,308 @@
+#pragma once
+#include "../sink.h"
+#include "../taps/low_pass.h"
+#include "../math/phasor.h"
+#include <fftw3.h>
+#include "../../utils/fft_plan.h"
+#include <stdint.h>
+
+namespace dsp::channel {
+    // Overlap-save FFT channelizer. The input is transformed once per hop and every
+    // channel is extracted from the shared spectrum, filtered and decimated in the
+    // frequency domain, so the cost per channel only depends on its output rate.
+    class Channelizer : public Sink<complex_t> {
+        using base_type = Sink<complex_t>;
+    public:
+        class Channel {
+        public:
+            stream<complex_t> out;
+
+            friend Channelizer;
+
+        private:
+            int decim;
+            int bins;
+            int bin;
+            int phaseStep;
+            int phaseIdx = 0;
+            double offset;
+            int outCount = 0;
+
+            complex_t* resp = NULL;
+            complex_t* ifftIn = NULL;
+            complex_t* ifftOut = NULL;
+            fftwf_plan plan = NULL;
+        };
+
+        Channelizer() {}
+
+        Channelizer(stream<complex_t>* in, double samplerate, int fftSize = 8192) { init(in, samplerate, fftSize); }
+
+        ~Channelizer() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            for (auto& ch : channels) {
+                destroyChannel(ch);
+                delete ch;
+            }
+            channels.clear();
+            fftplan::destroy(forwardPlan);
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
+            buffer::free(buffer);
+        }
+
+        void init(stream<complex_t>* in, double samplerate, int fftSize = 8192) {
+            assert(!(fftSize & (fftSize - 1)) && fftSize >= 256);
+            _samplerate = samplerate;
+            _fftSize = fftSize;
+            overlap = _fftSize / 4;
+            hop = _fftSize - overlap;
+
+            // A hop gives up to hop samples to a channel, limit the hops per call so that they fit in its buffer
+            maxHops = STREAM_BUFFER_SIZE / hop;
+
+            // Allocate FFT buffers and plan the shared forward FFT
+            fftIn = (complex_t*)fftwf_malloc(_fftSize * sizeof(complex_t));
+            fftOut = (complex_t*)fftwf_malloc(_fftSize * sizeof(complex_t));
+            forwardPlan = fftplan::createEstimate(_fftSize, (fftwf_complex*)fftIn, (fftwf_complex*)fftOut, FFTW_FORWARD);
+
+            // Allocate and clear the input buffer (primed with the overlap)
+            buffer = buffer::alloc<complex_t>(STREAM_BUFFER_SIZE + _fftSize);
+            buffer::clear(buffer, overlap);
+            bufferCount = overlap;
+
+            base_type::init(in);
+        }
+
+        Channel* addChannel(double offset, int decimation) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            assert(checkDecimation(decimation));
+            base_type::tempStop();
+
+            Channel* ch = new Channel;
+            ch->offset = offset;
+            buildChannel(ch, decimation);
+            updateBin(ch);
+            channels.push_back(ch);
+            base_type::registerOutput(&ch->out);
+
+            base_type::tempStart();
+            return ch;
+        }
+
+        void removeChannel(Channel* ch) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+
+            // Check that the channel belongs to this channelizer
+            auto cit = std::find(channels.begin(), channels.end(), ch);
+            if (cit == channels.end()) {
+                throw std::runtime_error("[Channelizer] Tried to remove a channel that doesn't exist");
+            }
+
+            base_type::tempStop();
+            channels.erase(cit);
+            base_type::unregisterOutput(&ch->out);
+            base_type::tempStart();
+
+            destroyChannel(ch);
+            delete ch;
+        }
+
+        void setOffset(Channel* ch, double offset) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            std::lock_guard<std::mutex> lck2(binMtx);
+            ch->offset = offset;
+            updateBin(ch);
+        }
+
+        void setDecimation(Channel* ch, int decimation) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            assert(checkDecimation(decimation));
+            if (ch->decim == decimation) { return; }
+            base_type::tempStop();
+            destroyChannel(ch);
+            buildChannel(ch, decimation);
+            updateBin(ch);
+            base_type::tempStart();
+        }
+
+        void setSamplerate(double samplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _samplerate = samplerate;
+            for (auto& ch : channels) { updateBin(ch); }
+            base_type::tempStart();
+        }
+
+        // Offset left after snapping the channel to the closest FFT bin, must be corrected downstream
+        double getResidualOffset(Channel* ch) {
+            return ch->offset - (double)ch->bin * _samplerate / (double)_fftSize;
+        }
+
+        double getChannelSamplerate(Channel* ch) {
+            return _samplerate / (double)ch->decim;
+        }
+
+        inline int getMaxDecimation() {
+            return _fftSize / 64;
+        }
+
+        // Highest power of two decimation that keeps the channel samplerate at least twice the requested one
+        int getDecimation(double minSamplerate) {
+            int decim = 1;
+            while (decim < getMaxDecimation() && _samplerate / (double)(decim * 2) >= 2.0 * minSamplerate) { decim *= 2; }
+            return decim;
+        }
+
+        int process(int count, const complex_t* in) {
+            // Append new samples after the ones left from the last call
+            memcpy(&buffer[bufferCount], in, count * sizeof(complex_t));
+            bufferCount += count;
+
+            processHops();
+            return count;
+        }
+
+        // Process as many complete hops as fit in the output buffers, the rest is left for the next call
+        void processHops() {
+            // Clear channel output counts
+            for (auto& ch : channels) { ch->outCount = 0; }
+
+            // Process complete hops
+            std::lock_guard<std::mutex> lck(binMtx);
+            int offset = 0;
+            for (int i = 0; i < maxHops && offset + _fftSize <= bufferCount; i++, offset += hop) {
+                // Do the shared forward FFT
+                memcpy(fftIn, &buffer[offset], _fftSize * sizeof(complex_t));
+                fftwf_execute(forwardPlan);
+
+                // Extract each channel
+                for (auto& ch : channels) {
+                    extractChannel(ch);
+                }
+            }
+
+            // Keep the samples that weren't consumed
+            bufferCount -= offset;
+            memmove(buffer, &buffer[offset], bufferCount * sizeof(complex_t));
+        }
+
+        int run() {
+            // Hops left over from a large input block are processed before reading more. Every stream is
+            // read and swapped at most once per call so that the block can run on a scheduler.
+            int count = 0;
+            if (bufferCount < _fftSize) {
+                count = base_type::_in->read();
+                if (count < 0) { return -1; }
+
+                process(count, base_type::_in->readBuf);
+
+                base_type::_in->flush();
+            }
+            else {
+                processHops();
+            }
+
+            // Swap every channel that got data
+            for (auto& ch : channels) {
+                if (!ch->outCount) { continue; }
+                if (!ch->out.swap(ch->outCount)) { return -1; }
+            }
+
+            return count;
+        }
+
+    protected:
+        bool checkDecimation(int decimation) {
+            return decimation > 0 && !(decimation & (decimation - 1)) && decimation <= getMaxDecimation();
+        }
+
+        void buildChannel(Channel* ch, int decimation) {
+            ch->decim = decimation;
+            ch->bins = _fftSize / decimation;
+            ch->ifftIn = (complex_t*)fftwf_malloc(ch->bins * sizeof(complex_t));
+            ch->ifftOut = (complex_t*)fftwf_malloc(ch->bins * sizeof(complex_t));
+            ch->plan = fftplan::createEstimate(ch->bins, (fftwf_complex*)ch->ifftIn, (fftwf_complex*)ch->ifftOut, FFTW_BACKWARD);
+
+            // Generate a low-pass for the channel that fits in the overlap (normalized to the input samplerate)
+            double chanRate = 1.0 / (double)decimation;
+            tap<float> ftaps = taps::lowPass(0.375 * chanRate, 0.25 * chanRate, 1.0);
+            assert(ftaps.size <= overlap + 1);
+
+            // Compute its frequency response using the shared FFT buffers (safe since the block is stopped)
+            buffer::clear(fftIn, _fftSize);
+            for (int i = 0; i < ftaps.size; i++) { fftIn[i] = { ftaps.taps[i], 0.0f }; }
+            taps::free(ftaps);
+            fftwf_execute(forwardPlan);
+
+            // Keep only the bins around DC and include the FFT normalization
+            ch->resp = buffer::alloc<complex_t>(ch->bins);
+            int half = ch->bins / 2;
+            float norm = 1.0f / (float)_fftSize;
+            for (int i = 0; i < ch->bins; i++) {
+                ch->resp[i] = fftOut[(i < half) ? i : (_fftSize - ch->bins + i)] * norm;
+            }
+        }
+
+        void destroyChannel(Channel* ch) {
+            fftplan::destroy(ch->plan);
+            if (ch->ifftIn) { fftwf_free(ch->ifftIn); }
+            if (ch->ifftOut) { fftwf_free(ch->ifftOut); }
+            if (ch->resp) { buffer::free(ch->resp); }
+            ch->plan = NULL;
+            ch->ifftIn = NULL;
+            ch->ifftOut = NULL;
+            ch->resp = NULL;
+        }
+
+        void updateBin(Channel* ch) {
+            ch->bin = round(ch->offset * (double)_fftSize / _samplerate);
+            ch->phaseStep = (int)((((int64_t)ch->bin * (int64_t)hop) % _fftSize + _fftSize) % _fftSize);
+            ch->phaseIdx = 0;
+        }
+
+        inline void extractChannel(Channel* ch) {
+            // Gather the bins centered on the channel and apply the filter response
+            int half = ch->bins / 2;
+            int mask = _fftSize - 1;
+            for (int i = 0; i < ch->bins; i++) {
+                int id = (ch->bin + ((i < half) ? i : (i - ch->bins))) & mask;
+                ch->ifftIn[i] = fftOut[id] * ch->resp[i];
+            }
+
+            // Go back to the time domain at the decimated rate
+            fftwf_execute(ch->plan);
+
+            // Keep the valid part and undo the phase jump caused by the bin shift between hops
+            int discard = overlap / ch->decim;
+            int valid = ch->bins - discard;
+            complex_t* out = &ch->out.writeBuf[ch->outCount];
+            complex_t rot = math::phasor(-2.0f * FL_M_PI * (float)ch->phaseIdx / (float)_fftSize);
+            volk_32fc_s32fc_multiply_32fc((lv_32fc_t*)out, (lv_32fc_t*)&ch->ifftOut[discard], *((lv_32fc_t*)&rot), valid);
+            ch->outCount += valid;
+            ch->phaseIdx = (ch->phaseIdx + ch->phaseStep) % _fftSize;
+        }
+
+        double _samplerate;
+        int _fftSize;
+        int overlap;
+        int hop;
+        int maxHops;
+
+        complex_t* fftIn;
+        complex_t* fftOut;
+        fftwf_plan forwardPlan;
+
+        complex_t* buffer;
+        int bufferCount;
+
+        std::vector<Channel*> channels;
+        std::mutex binMtx;
+    };
+}
@@ -0,0 +1,216 @@
+#pragma once
+#include "../processor.h"
+#include "../math/hz_to_rads.h"
+#include "../taps/windowed_sinc.h"
+#include "../window/nuttall.h"
+
+// Number of output samples generated per pass through the work buffers
+#define REAL_DDC_CHUNK_SIZE     8192
+
+// Tap count of the half-band filter, must be of the form 4k + 3
+#define REAL_DDC_TAP_COUNT      39
+
+namespace dsp::channel {
+    // Digital down converter for real samples such as those of a direct sampling ADC. The input is
+    // mixed down by the offset and decimated by two with a half-band filter, giving complex samples
+    // at half the input samplerate. The input is split into its even and odd samples so that each
+    // half is mixed with its own NCO and only the non-zero taps of the half-band filter are computed.
+    // T can be float or int16_t, in which case the samples are scaled to [-1, 1].
+    template <class T>
+    class RealDDC : public Processor<T, complex_t> {
+        using base_type = Processor<T, complex_t>;
+    public:
+        RealDDC() {}
+
+        RealDDC(stream<T>* in, double offset, double inSamplerate) { init(in, offset, inSamplerate); }
+
+        ~RealDDC() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(evenIn);
+            buffer::free(oddIn);
+            buffer::free(evenNco);
+            buffer::free(oddNco);
+            buffer::free(ones);
+            buffer::free(evenBuf);
+            buffer::free(oddBuf);
+            taps::free(evenTaps);
+        }
+
+        void init(stream<T>* in, double offset, double inSamplerate) {
+            _offset = offset;
+            _inSamplerate = inSamplerate;
+            phase = lv_cmake(1.0f, 0.0f);
+            updateNCO();
+            generateTaps();
+
+            // Allocate the work buffers, the filter buffers start with the history
+            evenIn = buffer::alloc<float>(REAL_DDC_CHUNK_SIZE);
+            oddIn = buffer::alloc<float>(REAL_DDC_CHUNK_SIZE);
+            evenNco = buffer::alloc<complex_t>(REAL_DDC_CHUNK_SIZE);
+            oddNco = buffer::alloc<complex_t>(REAL_DDC_CHUNK_SIZE);
+            ones = buffer::alloc<complex_t>(REAL_DDC_CHUNK_SIZE);
+            for (int i = 0; i < REAL_DDC_CHUNK_SIZE; i++) { ones[i] = { 1.0f, 0.0f }; }
+            evenBuf = buffer::alloc<complex_t>(REAL_DDC_CHUNK_SIZE + histLen);
+            oddBuf = buffer::alloc<complex_t>(REAL_DDC_CHUNK_SIZE + histLen);
+            buffer::clear(evenBuf, histLen);
+            buffer::clear(oddBuf, histLen);
+            leftover = false;
+
+            base_type::init(in);
+        }
+
+        void setOffset(double offset) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _offset = offset;
+            updateNCO();
+        }
+
+        void setInSamplerate(double inSamplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _inSamplerate = inSamplerate;
+            updateNCO();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            phase = lv_cmake(1.0f, 0.0f);
+            buffer::clear(evenBuf, histLen);
+            buffer::clear(oddBuf, histLen);
+            leftover = false;
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const T* in, complex_t* out) {
+            int outCount = 0;
+
+            // Complete the pair started by the last sample of the previous call
+            if (leftover && count) {
+                evenIn[0] = leftoverSample;
+                oddIn[0] = toFloat(in[0]);
+                outCount += processPairs(1, &out[outCount]);
+                in++;
+                count--;
+                leftover = false;
+            }
+
+            // Process all complete pairs one chunk at a time
+            int pairs = count / 2;
+            for (int offset = 0; offset < pairs; offset += REAL_DDC_CHUNK_SIZE) {
+                int n = std::min<int>(REAL_DDC_CHUNK_SIZE, pairs - offset);
+                if constexpr (std::is_same_v<T, int16_t>) {
+                    volk_16ic_s32f_deinterleave_32f_x2(evenIn, oddIn, (const lv_16sc_t*)&in[2 * offset], 32768.0f, n);
+                }
+                else {
+                    volk_32fc_deinterleave_32f_x2(evenIn, oddIn, (const lv_32fc_t*)&in[2 * offset], n);
+                }
+                outCount += processPairs(n, &out[outCount]);
+            }
+
+            // Keep the odd sample out for the next call
+            if (count & 1) {
+                leftoverSample = toFloat(in[count - 1]);
+                leftover = true;
+            }
+
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        static inline float toFloat(T sample) {
+            if constexpr (std::is_same_v<T, int16_t>) {
+                return (float)sample / 32768.0f;
+            }
+            else {
+                return sample;
+            }
+        }
+
+        int processPairs(int count, complex_t* out) {
+            complex_t* evenStart = &evenBuf[histLen];
+            complex_t* oddStart = &oddBuf[histLen];
+
+            // Generate the NCO for the even samples, the odd ones are one sample further
+#if VOLK_VERSION >= 030100
+            volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)evenNco, (lv_32fc_t*)ones, &pairDelta, &phase, count);
+#else
+            volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)evenNco, (lv_32fc_t*)ones, pairDelta, &phase, count);
+#endif
+            volk_32fc_s32fc_multiply_32fc((lv_32fc_t*)oddNco, (lv_32fc_t*)evenNco, phaseDelta, count);
+
+            // Mix both halves down
+            volk_32fc_32f_multiply_32fc((lv_32fc_t*)evenStart, (lv_32fc_t*)evenNco, evenIn, count);
+            volk_32fc_32f_multiply_32fc((lv_32fc_t*)oddStart, (lv_32fc_t*)oddNco, oddIn, count);
+
+            // Half-band filter, the even samples go through the non-zero taps and the odd ones only through the center tap
+            for (int i = 0; i < count; i++) {
+                volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&evenBuf[i], evenTaps.taps, evenTaps.size);
+                out[i] = out[i] + oddBuf[i + centerOffset] * centerTap;
+            }
+
+            // Move the history to the start of the buffers
+            memmove(evenBuf, &evenBuf[count], histLen * sizeof(complex_t));
+            memmove(oddBuf, &oddBuf[count], histLen * sizeof(complex_t));
+
+            return count;
+        }
+
+        void updateNCO() {
+            // Mix by the negative offset to bring it to DC
+            double omega = -math::hzToRads(_offset, _inSamplerate);
+            phaseDelta = lv_cmake((float)cos(omega), (float)sin(omega));
+            pairDelta = lv_cmake((float)cos(2.0 * omega), (float)sin(2.0 * omega));
+        }
+
+        void generateTaps() {
+            // Cutoff at a quarter of the input samplerate makes every other tap zero except the center one
+            tap<float> hb = taps::windowedSinc<float>(REAL_DDC_TAP_COUNT, DB_M_PI / 2.0, window::nuttall);
+            evenTaps = taps::alloc<float>((REAL_DDC_TAP_COUNT + 1) / 2);
+            for (int i = 0; i < evenTaps.size; i++) { evenTaps.taps[i] = hb.taps[2 * i]; }
+            centerTap = hb.taps[REAL_DDC_TAP_COUNT / 2];
+            centerOffset = REAL_DDC_TAP_COUNT / 4;
+            histLen = evenTaps.size - 1;
+            taps::free(hb);
+        }
+
+        double _offset;
+        double _inSamplerate;
+        lv_32fc_t phase;
+        lv_32fc_t phaseDelta;
+        lv_32fc_t pairDelta;
+
+        tap<float> evenTaps;
+        float centerTap;
+        int centerOffset;
+        int histLen;
+
+        float* evenIn;
+        float* oddIn;
+        complex_t* evenNco;
+        complex_t* oddNco;
+        complex_t* ones;
+        complex_t* evenBuf;
+        complex_t* oddBuf;
+
+        bool leftover;
+        float leftoverSample;
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "frequency_xlator.h"
 #include "../multirate/rational_resampler.h"
+#include "../filter/fft_fir.h"
 
 namespace dsp::channel {
     class RxVFO : public Processor<complex_t, complex_t> {
@@ -122,7 +123,7 @@ namespace dsp::channel {
 
         FrequencyXlator xlator;
         multirate::RationalResampler<complex_t> resamp;
-        filter::FIR<complex_t, float> filter;
+        filter::FFTFIR<complex_t, float> filter;
         tap<float> ftaps;
         bool filterNeeded;
 
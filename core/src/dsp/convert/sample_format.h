@@ -0,0 +1,164 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <volk/volk.h>
+#include "../types.h"
+
+// Number of values unpacked at once into a scratch buffer before being converted by volk
+#define SAMPLE_CONVERT_CHUNK    4096
+
+// Conversion of the raw IQ formats produced by the hardware to complex_t. All formats are interleaved
+// I then Q. The bulk of the work is done by volk which picks the best SIMD kernel at runtime, formats
+// that volk doesn't know are first unpacked to a wider integer in cache sized chunks.
+namespace dsp::convert {
+    enum SampleFormat {
+        SAMPLE_FORMAT_U8,
+        SAMPLE_FORMAT_S8,
+        SAMPLE_FORMAT_S12_PACKED,
+        SAMPLE_FORMAT_S16,
+        SAMPLE_FORMAT_S24_LE,
+        SAMPLE_FORMAT_S24_BE,
+        SAMPLE_FORMAT_S32,
+        SAMPLE_FORMAT_F32
+    };
+
+    // Size in bytes of one IQ pair
+    inline int sampleFormatSize(SampleFormat format) {
+        switch (format) {
+        case SAMPLE_FORMAT_U8:
+        case SAMPLE_FORMAT_S8:
+            return 2;
+        case SAMPLE_FORMAT_S12_PACKED:
+            return 3;
+        case SAMPLE_FORMAT_S16:
+            return 4;
+        case SAMPLE_FORMAT_S24_LE:
+        case SAMPLE_FORMAT_S24_BE:
+            return 6;
+        default:
+            return 8;
+        }
+    }
+
+    // Unsigned offset binary. The zero isn't always the middle of the range, the RTL2832U is closer to 127.4
+    inline void u8ToComplex(const uint8_t* in, complex_t* out, int count, float zero = 128.0f, float scale = 128.0f) {
+        // The table is only rebuilt when the parameters change
+        thread_local float lut[256];
+        thread_local float lutZero = NAN;
+        thread_local float lutScale = NAN;
+        if (zero != lutZero || scale != lutScale) {
+            for (int i = 0; i < 256; i++) { lut[i] = ((float)i - zero) / scale; }
+            lutZero = zero;
+            lutScale = scale;
+        }
+
+        float* fout = (float*)out;
+        int valCount = count * 2;
+        for (int i = 0; i < valCount; i++) { fout[i] = lut[in[i]]; }
+    }
+
+    inline void s8ToComplex(const int8_t* in, complex_t* out, int count, float scale = 128.0f) {
+        volk_8i_s32f_convert_32f((float*)out, in, scale, count * 2);
+    }
+
+    // Two 12bit values packed little endian in three bytes
+    inline void s12PackedToComplex(const uint8_t* in, complex_t* out, int count, float scale = 2048.0f) {
+        // Values are placed in the top of an int16 so the sign comes for free
+        int16_t buf[SAMPLE_CONVERT_CHUNK];
+        float* fout = (float*)out;
+        int valCount = count * 2;
+        for (int off = 0; off < valCount; off += SAMPLE_CONVERT_CHUNK) {
+            int len = std::min<int>(SAMPLE_CONVERT_CHUNK, valCount - off);
+            const uint8_t* src = &in[(off / 2) * 3];
+            for (int i = 0; i < len; i += 2) {
+                buf[i] = (int16_t)((((uint16_t)src[1] & 0x0F) << 12) | ((uint16_t)src[0] << 4));
+                buf[i + 1] = (int16_t)(((uint16_t)src[2] << 8) | ((uint16_t)src[1] & 0xF0));
+                src += 3;
+            }
+            volk_16i_s32f_convert_32f(&fout[off], buf, scale * 16.0f, len);
+        }
+    }
+
+    inline void s16ToComplex(const int16_t* in, complex_t* out, int count, float scale = 32768.0f) {
+        volk_16i_s32f_convert_32f((float*)out, in, scale, count * 2);
+    }
+
+    // 24bit values, stride is the number of bytes from one IQ pair to the next for devices that interleave other data
+    template <bool BigEndian>
+    inline void s24ToComplex(const uint8_t* in, complex_t* out, int count, int stride = 6, float scale = 8388608.0f) {
+        // Values are placed in the top of an int32 so the sign comes for free
+        int32_t buf[SAMPLE_CONVERT_CHUNK];
+        float* fout = (float*)out;
+        for (int off = 0; off < count; off += SAMPLE_CONVERT_CHUNK / 2) {
+            int len = std::min<int>(SAMPLE_CONVERT_CHUNK / 2, count - off);
+            const uint8_t* src = &in[off * stride];
+            for (int i = 0; i < len; i++) {
+                for (int j = 0; j < 2; j++) {
+                    const uint8_t* b = &src[j * 3];
+                    if constexpr (BigEndian) {
+                        buf[(i * 2) + j] = (int32_t)(((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8));
+                    }
+                    else {
+                        buf[(i * 2) + j] = (int32_t)(((uint32_t)b[2] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[0] << 8));
+                    }
+                }
+                src += stride;
+            }
+            volk_32i_s32f_convert_32f(&fout[off * 2], buf, scale * 256.0f, len * 2);
+        }
+    }
+
+    inline void s24LEToComplex(const uint8_t* in, complex_t* out, int count, int stride = 6, float scale = 8388608.0f) {
+        s24ToComplex<false>(in, out, count, stride, scale);
+    }
+
+    inline void s24BEToComplex(const uint8_t* in, complex_t* out, int count, int stride = 6, float scale = 8388608.0f) {
+        s24ToComplex<true>(in, out, count, stride, scale);
+    }
+
+    inline void s32ToComplex(const int32_t* in, complex_t* out, int count, float scale = 2147483648.0f) {
+        volk_32i_s32f_convert_32f((float*)out, in, scale, count * 2);
+    }
+
+    // For devices that send Q before I
+    inline void swapIQ(complex_t* data, int count) {
+        for (int i = 0; i < count; i++) {
+            float re = data[i].re;
+            data[i].re = data[i].im;
+            data[i].im = re;
+        }
+    }
+
+    // Convert using the default scaling of the format
+    inline void toComplex(SampleFormat format, const void* in, complex_t* out, int count, bool swap = false) {
+        switch (format) {
+        case SAMPLE_FORMAT_U8:
+            u8ToComplex((const uint8_t*)in, out, count);
+            break;
+        case SAMPLE_FORMAT_S8:
+            s8ToComplex((const int8_t*)in, out, count);
+            break;
+        case SAMPLE_FORMAT_S12_PACKED:
+            s12PackedToComplex((const uint8_t*)in, out, count);
+            break;
+        case SAMPLE_FORMAT_S16:
+            s16ToComplex((const int16_t*)in, out, count);
+            break;
+        case SAMPLE_FORMAT_S24_LE:
+            s24LEToComplex((const uint8_t*)in, out, count);
+            break;
+        case SAMPLE_FORMAT_S24_BE:
+            s24BEToComplex((const uint8_t*)in, out, count);
+            break;
+        case SAMPLE_FORMAT_S32:
+            s32ToComplex((const int32_t*)in, out, count);
+            break;
+        case SAMPLE_FORMAT_F32:
+            memcpy(out, in, count * sizeof(complex_t));
+            break;
+        }
+        if (swap) { swapIQ(out, count); }
+    }
+}
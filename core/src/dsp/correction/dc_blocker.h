@@ -70,7 +70,13 @@ namespace dsp::correction {
             return count;
         }
 
+        bool fusable() { return true; }
+
     protected:
+        int doFusedProcess(int count, const T* in, T* out) {
+            return process(count, (T*)in, out);
+        }
+
         float _rate;
         T offset;
     };
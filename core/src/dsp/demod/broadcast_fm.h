@@ -3,6 +3,7 @@
 #include "../taps/low_pass.h"
 #include "../taps/band_pass.h"
 #include "../filter/fir.h"
+#include "../filter/fft_fir.h"
 #include "../loop/pll.h"
 #include "../convert/l_r_to_stereo.h"
 #include "../convert/real_to_complex.h"
@@ -240,7 +241,7 @@ namespace dsp::demod {
 
         Quadrature demod;
         tap<complex_t> pilotFirTaps;
-        filter::FIR<complex_t, complex_t> pilotFir;
+        filter::FFTFIR<complex_t, complex_t> pilotFir;
         convert::RealToComplex rtoc;
         channel::FrequencyXlator xlator;
         loop::PLL pilotPLL;
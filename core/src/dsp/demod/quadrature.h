@@ -1,10 +1,14 @@
 #pragma once
 #include "../processor.h"
-#include "../math/fast_atan2.h"
 #include "../math/hz_to_rads.h"
-#include "../math/normalize_phase.h"
+
+// Number of samples demodulated at once through the stack buffer
+#define QUADRATURE_CHUNK_SIZE   1024
 
 namespace dsp::demod {
+    // Polar discriminator computing the phase difference as arg(x[n] * conj(x[n-1])). Both the
+    // conjugate product and the atan2 are done by volk which picks the best SIMD kernel at runtime,
+    // and the phase difference comes out already wrapped to (-pi, pi].
     class Quadrature : public Processor<complex_t, float> {
         using base_type = Processor<complex_t, float>;
     public:
@@ -16,7 +20,7 @@ namespace dsp::demod {
 
         
         virtual void init(stream<complex_t>* in, double deviation) {
-            _invDeviation = 1.0 / deviation;
+            _deviation = deviation;
             base_type::init(in);
         }
 
@@ -27,20 +31,28 @@ namespace dsp::demod {
         void setDeviation(double deviation) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            _invDeviation = 1.0 / deviation;
+            _deviation = deviation;
         }
 
         void setDeviation(double deviation, double samplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            _invDeviation = 1.0 / math::hzToRads(deviation, samplerate);
+            _deviation = math::hzToRads(deviation, samplerate);
         }
 
         inline int process(int count, complex_t* in, float* out) {
-            for (int i = 0; i < count; i++) {
-                float cphase = in[i].phase();
-                out[i] = math::normalizePhase(cphase - phase) * _invDeviation;
-                phase = cphase;
+            alignas(32) complex_t prod[QUADRATURE_CHUNK_SIZE];
+            for (int offset = 0; offset < count; offset += QUADRATURE_CHUNK_SIZE) {
+                int n = std::min<int>(QUADRATURE_CHUNK_SIZE, count - offset);
+                complex_t* x = &in[offset];
+
+                // Multiply each sample by the conjugate of the previous one, the first uses the last sample of the previous chunk
+                prod[0] = x[0] * last.conj();
+                volk_32fc_x2_multiply_conjugate_32fc((lv_32fc_t*)&prod[1], (lv_32fc_t*)&x[1], (lv_32fc_t*)x, n - 1);
+
+                // The argument of the product is the phase difference, scaled by the deviation
+                volk_32fc_s32f_atan2_32f(&out[offset], (lv_32fc_t*)prod, _deviation, n);
+                last = x[n - 1];
             }
             return count;
         }
@@ -48,7 +60,7 @@ namespace dsp::demod {
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            phase = 0.0f;
+            last = { 1.0f, 0.0f };
         }
 
         int run() {
@@ -63,7 +75,7 @@ namespace dsp::demod {
         }
 
     protected:
-        float _invDeviation;
-        float phase = 0.0f;
+        float _deviation;
+        complex_t last = { 1.0f, 0.0f };
     };
 }
\ No newline at end of file
@@ -87,6 +87,13 @@ namespace dsp::filter {
             return count;
         }
 
+        bool fusable() { return true; }
+
+    protected:
+        int doFusedProcess(int count, const T* in, T* out) {
+            return process(count, in, out);
+        }
+
     private:
         void updateAlpha() {
             float dt = 1.0f / _samplerate;
@@ -0,0 +1,156 @@
+#pragma once
+#include "fir.h"
+#include <fftw3.h>
+#include "../../utils/fft_plan.h"
+#include <math.h>
+
+// Filters shorter than this always use direct convolution
+#define FFT_FIR_MIN_TAPS    64
+
+namespace dsp::filter {
+    // FIR filter using overlap-save FFT convolution when it's cheaper than direct convolution.
+    // The choice is made on each call from the tap count and the number of samples, both paths
+    // share the same history so switching between them is seamless. The output is identical to FIR.
+    template <class D, class T>
+    class FFTFIR : public FIR<D, T> {
+        using base_type = FIR<D, T>;
+    public:
+        FFTFIR() {}
+
+        FFTFIR(stream<D>* in, tap<T>& taps) { init(in, taps); }
+
+        ~FFTFIR() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            destroyFFT();
+        }
+
+        virtual void init(stream<D>* in, tap<T>& taps) {
+            base_type::init(in, taps);
+            buildFFT();
+        }
+
+        virtual void setTaps(tap<T>& taps) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            base_type::setTaps(taps);
+            destroyFFT();
+            buildFFT();
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const D* in, D* out) {
+            if (!useFFT(count)) { return base_type::process(count, in, out); }
+
+            // Copy data to work buffer
+            memcpy(base_type::bufStart, in, count * sizeof(D));
+
+            // Filter one block of at most a hop at a time
+            for (int offset = 0; offset < count; offset += hop) {
+                convolveBlock(&base_type::buffer[offset], &out[offset], std::min<int>(hop, count - offset));
+            }
+
+            // Move unused data
+            memmove(base_type::buffer, &base_type::buffer[count], (base_type::_taps.size - 1) * sizeof(D));
+
+            return count;
+        }
+
+        virtual int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+
+    protected:
+        void buildFFT() {
+            int tapCount = base_type::_taps.size;
+            if (tapCount < FFT_FIR_MIN_TAPS) { return; }
+
+            // Pick a power of two size that leaves at least 3/4 of each transform for new samples
+            fftSize = 256;
+            while (fftSize < 4 * (tapCount - 1)) { fftSize *= 2; }
+            hop = fftSize - (tapCount - 1);
+            fftCost = 6.0 * (double)fftSize * log2((double)fftSize);
+
+            fftIn = (complex_t*)fftwf_malloc(fftSize * sizeof(complex_t));
+            fftOut = (complex_t*)fftwf_malloc(fftSize * sizeof(complex_t));
+            forwardPlan = fftplan::createEstimate(fftSize, (fftwf_complex*)fftIn, (fftwf_complex*)fftOut, FFTW_FORWARD);
+            backwardPlan = fftplan::createEstimate(fftSize, (fftwf_complex*)fftOut, (fftwf_complex*)fftIn, FFTW_BACKWARD);
+
+            // The direct form correlates with the taps, so transform them reversed. The IFFT scaling is folded in.
+            buffer::clear(fftIn, fftSize);
+            for (int i = 0; i < tapCount; i++) {
+                if constexpr (std::is_same_v<T, float>) {
+                    fftIn[i] = { base_type::_taps.taps[tapCount - 1 - i], 0.0f };
+                }
+                else {
+                    fftIn[i] = base_type::_taps.taps[tapCount - 1 - i];
+                }
+            }
+            fftwf_execute(forwardPlan);
+            resp = buffer::alloc<complex_t>(fftSize);
+            float norm = 1.0f / (float)fftSize;
+            for (int i = 0; i < fftSize; i++) { resp[i] = fftOut[i] * norm; }
+        }
+
+        void destroyFFT() {
+            if (!fftSize) { return; }
+            fftplan::destroy(forwardPlan);
+            fftplan::destroy(backwardPlan);
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
+            buffer::free(resp);
+            fftSize = 0;
+        }
+
+        inline bool useFFT(int count) {
+            if (!fftSize) { return false; }
+
+            // Compare the multiply-accumulates of the direct form with a rough cost of the transforms
+            int blocks = (count + hop - 1) / hop;
+            return (double)count * (double)base_type::_taps.size > (double)blocks * fftCost;
+        }
+
+        inline void convolveBlock(const D* in, D* out, int count) {
+            // Load the history and the new samples, the padding only affects the discarded outputs
+            int histCount = base_type::_taps.size - 1;
+            int total = histCount + count;
+            if constexpr (std::is_same_v<D, float>) {
+                for (int i = 0; i < total; i++) { fftIn[i] = { in[i], 0.0f }; }
+            }
+            else {
+                memcpy(fftIn, in, total * sizeof(complex_t));
+            }
+            buffer::clear(fftIn, fftSize - total, total);
+
+            // Circular convolution with the taps
+            fftwf_execute(forwardPlan);
+            volk_32fc_x2_multiply_32fc((lv_32fc_t*)fftOut, (lv_32fc_t*)fftOut, (lv_32fc_t*)resp, fftSize);
+            fftwf_execute(backwardPlan);
+
+            // Keep the outputs that didn't wrap around
+            if constexpr (std::is_same_v<D, float>) {
+                volk_32fc_deinterleave_real_32f(out, (lv_32fc_t*)&fftIn[histCount], count);
+            }
+            else {
+                memcpy(out, &fftIn[histCount], count * sizeof(D));
+            }
+        }
+
+        int fftSize = 0;
+        int hop;
+        double fftCost;
+        complex_t* fftIn;
+        complex_t* fftOut;
+        complex_t* resp;
+        fftwf_plan forwardPlan;
+        fftwf_plan backwardPlan;
+    };
+}
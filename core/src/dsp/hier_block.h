@@ -50,6 +50,15 @@ namespace dsp {
             }
         }
 
+        // Run every sub-block as a task on a scheduler, see block::setScheduler()
+        virtual void setScheduler(Scheduler* scheduler) {
+            assert(_block_init);
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            for (auto& block : blocks) {
+                block->setScheduler(scheduler);
+            }
+        }
+
     private:
         virtual void doStart() {
             for (auto& block : blocks) {
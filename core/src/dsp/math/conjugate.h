@@ -24,5 +24,12 @@ namespace dsp::math {
             if (!base_type::out.swap(count)) { return -1; }
             return count;
         }
+
+        bool fusable() { return true; }
+
+    protected:
+        int doFusedProcess(int count, const complex_t* in, complex_t* out) {
+            return process(count, in, out);
+        }
     };
 }
\ No newline at end of file
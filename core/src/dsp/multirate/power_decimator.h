@@ -51,7 +51,7 @@ namespace dsp::multirate {
         inline int process(int count, const T* in, T* out) {
             // If the ratio is 1, no need to decimate
             if (_ratio == 1) {
-                memcpy(out, in, count * sizeof(T));
+                if (out != in) { memcpy(out, in, count * sizeof(T)); }
                 return count;
             }
             
@@ -80,7 +80,13 @@ namespace dsp::multirate {
             return outCount;
         }
 
+        bool fusable() { return true; }
+
     protected:
+        int doFusedProcess(int count, const T* in, T* out) {
+            return process(count, in, out);
+        }
+
         void freeFirs() {
             for (auto& fir : decimFirs) { delete fir; }
             for (auto& taps : decimTaps) { taps::free(taps); }
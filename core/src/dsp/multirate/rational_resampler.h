@@ -89,7 +89,7 @@ namespace dsp::multirate {
                 case Mode::RESAMP_ONLY:
                     return resamp.process(count, in, out);
                 case Mode::NONE:
-                    memcpy(out, in, count * sizeof(T));
+                    if (out != in) { memcpy(out, in, count * sizeof(T)); }
                     return count;
             }
             return count;
@@ -109,7 +109,13 @@ namespace dsp::multirate {
             return outCount;
         }
 
+        bool fusable() { return true; }
+
     protected:
+        int doFusedProcess(int count, const T* in, T* out) {
+            return process(count, in, out);
+        }
+
         enum Mode {
             BOTH,
             DECIM_ONLY,
@@ -1,9 +1,16 @@
 #pragma once
 #include "../processor.h"
-#include "../window/nuttall.h"
 #include <fftw3.h>
+#include "../../utils/fft_plan.h"
+
+// Number of samples after which the sliding DFT is recomputed from scratch to clear rounding errors
+#define FMIF_RESYNC_INTERVAL    1024
 
 namespace dsp::noise_reduction {
+    // Keeps only the strongest frequency bin of a Nuttall windowed DFT sliding one sample at a time.
+    // The DFT is updated recursively in O(bins) per sample and the window is applied in the frequency
+    // domain as a 7 tap kernel over neighbouring bins, so no FFT is needed per sample. See FFTFMIF for
+    // the original implementation, the only difference is that the window is periodic instead of symmetric.
     class FMIF : public Processor<complex_t, complex_t> {
         using base_type = Processor<complex_t, complex_t>;
     public:
@@ -38,37 +45,50 @@ namespace dsp::noise_reduction {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             buffer::clear(buffer, _bins - 1);
-            buffer::clear(backFFTIn, _bins);
+            buffer::clear(spectrum, _bins + 6);
+            oldest = { 0.0f, 0.0f };
+            sinceResync = 0;
             base_type::tempStart();
         }
 
         int process(int count, const complex_t* in, complex_t* out) {
             // Write new input data to buffer buffer
             memcpy(bufferStart, in, count * sizeof(complex_t));
-            
-            // Iterate the FFT
-            for (int i = 0; i < count; i++) {
-                // Apply windows
-                volk_32fc_32f_multiply_32fc((lv_32fc_t*)forwFFTIn, (lv_32fc_t*)&buffer[i], fftWin, _bins);
-
-                // Do forward FFT
-                fftwf_execute(forwardPlan);
-
-                // Process bins here
-                uint32_t idx;
-                volk_32fc_magnitude_32f(ampBuf, (lv_32fc_t*)forwFFTOut, _bins);
-                volk_32f_index_max_32u(&idx, ampBuf, _bins);
-
-                // Keep only the bin of highest amplitude
-                backFFTIn[idx] = forwFFTOut[idx];
-
-                // Do reverse FFT and get first element
-                fftwf_execute(backwardPlan);
-                out[i] = backFFTOut[_bins / 2];
 
-                // Reset the input buffer
-                backFFTIn[idx] = { 0, 0 };
+            complex_t* bins = &spectrum[3];
+            for (int i = 0; i < count; i++) {
+                // Slide the DFT by one sample, recomputing it every once in a while
+                if (++sinceResync >= FMIF_RESYNC_INTERVAL) {
+                    resync(&buffer[i]);
+                }
+                else {
+                    complex_t prev = i ? buffer[i - 1] : oldest;
+                    slide(buffer[i + _bins - 1] - prev);
+                }
+
+                // Make the bins circular for the window kernel
+                for (int j = 0; j < 3; j++) {
+                    spectrum[j] = bins[(_bins - 3 + j) % _bins];
+                    bins[_bins + j] = bins[j % _bins];
+                }
+
+                // Find the strongest bin of the windowed spectrum
+                int idx = 0;
+                float maxAmp = -1.0f;
+                for (int k = 0; k < _bins; k++) {
+                    complex_t w = windowed(bins, k);
+                    float amp = w.re * w.re + w.im * w.im;
+                    if (amp > maxAmp) {
+                        maxAmp = amp;
+                        idx = k;
+                    }
+                }
+
+                // Output the value of that bin alone at the center of the window
+                complex_t w = windowed(bins, idx);
+                out[i] = (idx & 1) ? complex_t{ -w.re, -w.im } : w;
             }
+            oldest = buffer[count - 1];
 
             // Move buffer buffer
             memmove(buffer, &buffer[count], (_bins - 1) * sizeof(complex_t));
@@ -88,62 +108,85 @@ namespace dsp::noise_reduction {
             return count;
         }
 
+        bool fusable() { return true; }
+
     protected:
+        int doFusedProcess(int count, const complex_t* in, complex_t* out) {
+            return process(count, in, out);
+        }
+
+        inline void slide(complex_t delta) {
+            // X[k] = (X[k] - x[n - N] + x[n]) * e^(j*2*pi*k/N)
+            complex_t* bins = &spectrum[3];
+            for (int k = 0; k < _bins; k++) {
+                float re = bins[k].re + delta.re;
+                float im = bins[k].im + delta.im;
+                bins[k].re = re * twiddles[k].re - im * twiddles[k].im;
+                bins[k].im = re * twiddles[k].im + im * twiddles[k].re;
+            }
+        }
+
+        void resync(const complex_t* window) {
+            memcpy(fftIn, window, _bins * sizeof(complex_t));
+            fftwf_execute(plan);
+            sinceResync = 0;
+        }
+
+        inline complex_t windowed(const complex_t* bins, int k) {
+            // Nuttall window coefficients halved for the neighbouring bins
+            const float a0 = 0.355768f;
+            const float a1 = -0.487396f * 0.5f;
+            const float a2 = 0.144232f * 0.5f;
+            const float a3 = -0.012604f * 0.5f;
+            return complex_t{
+                a0 * bins[k].re + a1 * (bins[k - 1].re + bins[k + 1].re) + a2 * (bins[k - 2].re + bins[k + 2].re) + a3 * (bins[k - 3].re + bins[k + 3].re),
+                a0 * bins[k].im + a1 * (bins[k - 1].im + bins[k + 1].im) + a2 * (bins[k - 2].im + bins[k + 2].im) + a3 * (bins[k - 3].im + bins[k + 3].im)
+            };
+        }
+
         void initBuffers() {
-            // Allocate FFT buffers
-            forwFFTIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            forwFFTOut = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            backFFTIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            backFFTOut = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
+            // Allocate and clear the spectrum, with 3 extra bins on each side to wrap around
+            spectrum = (complex_t*)fftwf_malloc((_bins + 6) * sizeof(complex_t));
+            buffer::clear(spectrum, _bins + 6);
+            fftIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
 
             // Allocate and clear delay buffer
             buffer = buffer::alloc<complex_t>(STREAM_BUFFER_SIZE + 64000);
             bufferStart = &buffer[_bins - 1];
             buffer::clear(buffer, _bins - 1);
+            oldest = { 0.0f, 0.0f };
+            sinceResync = 0;
+
+            // Generate the twiddle factors
+            twiddles = buffer::alloc<complex_t>(_bins);
+            for (int i = 0; i < _bins; i++) {
+                double phase = 2.0 * DB_M_PI * (double)i / (double)_bins;
+                twiddles[i] = { (float)cos(phase), (float)sin(phase) };
+            }
 
-            // Clear backward FFT input since only one value is changed and reset at a time
-            buffer::clear(backFFTIn, _bins);
-
-            // Allocate amplitude buffer
-            ampBuf = buffer::alloc<float>(_bins);
-
-            // Allocate and generate Window
-            fftWin = buffer::alloc<float>(_bins);
-            for (int i = 0; i < _bins; i++) { fftWin[i] = window::nuttall(i, _bins - 1); }
-
-            // Plan FFTs
-            forwardPlan = fftwf_plan_dft_1d(_bins, (fftwf_complex*)forwFFTIn, (fftwf_complex*)forwFFTOut, FFTW_FORWARD, FFTW_ESTIMATE);
-            backwardPlan = fftwf_plan_dft_1d(_bins, (fftwf_complex*)backFFTIn, (fftwf_complex*)backFFTOut, FFTW_BACKWARD, FFTW_ESTIMATE);
+            // Plan the FFT used to resynchronise, writing straight into the spectrum
+            plan = fftplan::createEstimate(_bins, (fftwf_complex*)fftIn, (fftwf_complex*)&spectrum[3], FFTW_FORWARD);
         }
 
         void destroyBuffers() {
-            fftwf_destroy_plan(forwardPlan);
-            fftwf_destroy_plan(backwardPlan);
-            fftwf_free(forwFFTIn);
-            fftwf_free(forwFFTOut);
-            fftwf_free(backFFTIn);
-            fftwf_free(backFFTOut);
+            fftplan::destroy(plan);
+            fftwf_free(spectrum);
+            fftwf_free(fftIn);
             buffer::free(buffer);
-            buffer::free(ampBuf);
-            buffer::free(fftWin);
+            buffer::free(twiddles);
         }
 
-        complex_t* forwFFTIn;
-        complex_t* forwFFTOut;
-        complex_t* backFFTIn;
-        complex_t* backFFTOut;
-
-        fftwf_plan forwardPlan;
-        fftwf_plan backwardPlan;
+        complex_t* spectrum;
+        complex_t* twiddles;
+        complex_t* fftIn;
+        fftwf_plan plan;
 
         complex_t* buffer;
         complex_t* bufferStart;
-
-        float* fftWin;
-
-        float* ampBuf;
+        complex_t oldest;
+        int sinceResync;
 
         int _bins;
 
-    }; 
-}
\ No newline at end of file
+    };
+}
@@ -67,7 +67,13 @@ namespace dsp::noise_reduction {
             return count;
         }
 
+        bool fusable() { return true; }
+
     protected:
+        int doFusedProcess(int count, const complex_t* in, complex_t* out) {
+            return process(count, (complex_t*)in, out);
+        }
+
         float _rate;
         float _invRate;
         float _level;
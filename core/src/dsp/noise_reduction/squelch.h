@@ -37,7 +37,7 @@ namespace dsp::noise_reduction {
             sum /= (float)count;
 
             if (10.0f * log10f(sum) >= _level) {
-                memcpy(out, in, count * sizeof(complex_t));
+                if (out != in) { memcpy(out, in, count * sizeof(complex_t)); }
             }
             else {
                 memset(out, 0, count * sizeof(complex_t));
@@ -57,6 +57,13 @@ namespace dsp::noise_reduction {
             return count;
         }
 
+        bool fusable() { return true; }
+
+    protected:
+        int doFusedProcess(int count, const complex_t* in, complex_t* out) {
+            return process(count, in, out);
+        }
+
     private:
         float* normBuffer;
         float _level = -50.0f;
@@ -66,9 +66,21 @@ namespace dsp {
 
         virtual int run() = 0;
 
+        // Process a buffer directly without going through the streams so that
+        // a chain can run this block on its own worker thread (see dsp::chain::setFused)
+        int fusedProcess(int count, const I* in, O* out) {
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            return doFusedProcess(count, in, out);
+        }
+
+        virtual bool fusable() { return false; }
+
         stream<O> out;
 
     protected:
+        // Must be overridden along with fusable(), the output buffer may be the same as the input buffer
+        virtual int doFusedProcess(int count, const I* in, O* out) { return -1; }
+
         stream<I>* _in;
     };
 }
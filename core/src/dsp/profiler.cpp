@@ -0,0 +1,141 @@
+#include "profiler.h"
+#include "block.h"
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <json.hpp>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <stdlib.h>
+#endif
+
+using nlohmann::json;
+
+namespace dsp::profiler {
+    struct Registry {
+        std::mutex mtx;
+        std::vector<block*> blocks;
+    };
+
+    std::atomic<bool> enabled = { false };
+    thread_local Counters* current = NULL;
+
+    // Function local so that blocks constructed during static initialization can register themselves
+    Registry& getRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    std::string demangle(const std::string& name) {
+#ifdef __GNUG__
+        int status = -1;
+        char* res = abi::__cxa_demangle(name.c_str(), NULL, NULL, &status);
+        if (!status && res) {
+            std::string out = res;
+            ::free(res);
+            return out;
+        }
+#endif
+        // MSVC already gives a readable name prefixed with the kind of type
+        if (!name.rfind("class ", 0)) { return name.substr(6); }
+        return name;
+    }
+
+    void setEnabled(bool enable) {
+        enabled = enable;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+    uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint64_t threadCpuTime() {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) { return 0; }
+        uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+        uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+        return (k + u) * 100;
+#else
+        timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts)) { return 0; }
+        return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+#endif
+    }
+
+    Counters* getCurrent() {
+        return enabled ? current : NULL;
+    }
+
+    void setCurrent(Counters* counters) {
+        current = counters;
+    }
+
+    void registerBlock(block* blk) {
+        Registry& reg = getRegistry();
+        std::lock_guard<std::mutex> lck(reg.mtx);
+        reg.blocks.push_back(blk);
+    }
+
+    void unregisterBlock(block* blk) {
+        Registry& reg = getRegistry();
+        std::lock_guard<std::mutex> lck(reg.mtx);
+        reg.blocks.erase(std::remove(reg.blocks.begin(), reg.blocks.end(), blk), reg.blocks.end());
+    }
+
+    std::vector<BlockStats> getStats() {
+        Registry& reg = getRegistry();
+        std::lock_guard<std::mutex> lck(reg.mtx);
+        std::vector<BlockStats> stats;
+        for (auto& blk : reg.blocks) {
+            // Skip blocks that were never started
+            std::string typeName = blk->getTypeName();
+            if (typeName.empty()) { continue; }
+
+            Counters& c = blk->getCounters();
+            BlockStats s;
+            s.id = blk;
+            s.name = blk->getName();
+            if (s.name.empty()) { s.name = demangle(typeName); }
+            s.scheduled = blk->isScheduled();
+            s.runs = c.runs;
+            s.samples = c.samples;
+            s.runNs = c.runNs;
+            s.waitNs = c.waitNs;
+            s.cpuNs = c.cpuNs;
+            stats.push_back(s);
+        }
+        return stats;
+    }
+
+    std::string dump() {
+        json out;
+        out["enabled"] = (bool)enabled;
+        out["timeNs"] = now();
+        out["blocks"] = json::array();
+        for (auto& s : getStats()) {
+            json b;
+            b["name"] = s.name;
+            b["scheduled"] = s.scheduled;
+            b["runs"] = s.runs;
+            b["samples"] = s.samples;
+            b["runNs"] = s.runNs;
+            b["waitNs"] = s.waitNs;
+            b["busyNs"] = s.runNs - std::min<uint64_t>(s.waitNs, s.runNs);
+            b["cpuNs"] = s.cpuNs;
+            out["blocks"].push_back(b);
+        }
+        return out.dump(4);
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Minimum time between two reads of the CPU time of a block's thread, in nanoseconds
+#define PROFILER_CPU_SAMPLE_INTERVAL    100000000
+
+namespace dsp {
+    class block;
+
+    // Runtime counters of the DSP blocks. Collection is off by default, when disabled the only cost
+    // is one check per call to run(). Time blocked in a stream is attributed to the block owning the
+    // thread that waited, blocks running on a scheduler never wait so their CPU time is their run time.
+    namespace profiler {
+        struct Counters {
+            std::atomic<uint64_t> runs = { 0 };
+            std::atomic<uint64_t> samples = { 0 };
+            // Time spent in run(), including the time blocked
+            std::atomic<uint64_t> runNs = { 0 };
+            // Time blocked in read() or swap()
+            std::atomic<uint64_t> waitNs = { 0 };
+            std::atomic<uint64_t> cpuNs = { 0 };
+            uint64_t lastCpuSample = 0;
+        };
+
+        struct BlockStats {
+            // Only used to tell blocks apart, never dereferenced
+            const void* id;
+            std::string name;
+            bool scheduled;
+            uint64_t runs;
+            uint64_t samples;
+            uint64_t runNs;
+            uint64_t waitNs;
+            uint64_t cpuNs;
+        };
+
+        void setEnabled(bool enabled);
+        bool isEnabled();
+
+        // Monotonic time in nanoseconds
+        uint64_t now();
+
+        // CPU time used by the calling thread in nanoseconds
+        uint64_t threadCpuTime();
+
+        // Counters of the block running on the calling thread, NULL if none
+        Counters* getCurrent();
+        void setCurrent(Counters* counters);
+
+        void registerBlock(block* blk);
+        void unregisterBlock(block* blk);
+
+        // Counters of all blocks that were started at least once
+        std::vector<BlockStats> getStats();
+
+        // Readable version of a type name given by typeid
+        std::string demangle(const std::string& name);
+
+        // All counters as a JSON document
+        std::string dump();
+
+        // Measures the time a stream spends waiting and adds it to the current block
+        class WaitTimer {
+        public:
+            WaitTimer() {
+                counters = getCurrent();
+                if (counters) { start = now(); }
+            }
+
+            ~WaitTimer() {
+                if (counters) { counters->waitNs += now() - start; }
+            }
+
+        private:
+            Counters* counters;
+            uint64_t start = 0;
+        };
+    }
+}
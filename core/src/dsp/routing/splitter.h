@@ -10,6 +10,34 @@ namespace dsp::routing {
 
         Splitter(stream<T>* in) { base_type::init(in); }
 
+        ~Splitter() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            if (pool) { pool->destroy(); }
+        }
+
+        // Publish each input buffer once as a reference counted block read by all bound streams
+        // instead of copying it into each of them. Readers must not modify the data they get.
+        void setShared(bool enabled) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            if (enabled == (pool != NULL)) { return; }
+            base_type::tempStop();
+            if (enabled) {
+                pool = buffer::SharedPool<T>::create(STREAM_BUFFER_SIZE);
+            }
+            else {
+                // Blocks still held by readers free themselves once released
+                pool->destroy();
+                pool = NULL;
+            }
+            base_type::tempStart();
+        }
+
+        bool getShared() {
+            return pool != NULL;
+        }
+
         void bindStream(stream<T>* stream) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
@@ -47,6 +75,8 @@ namespace dsp::routing {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            if (pool) { return runShared(count); }
+
             for (const auto& stream : streams) {
                 memcpy(stream->writeBuf, base_type::_in->readBuf, count * sizeof(T));
                 if (!stream->swap(count)) {
@@ -61,7 +91,31 @@ namespace dsp::routing {
         }
 
     protected:
+        int runShared(int count) {
+            if (streams.empty()) {
+                base_type::_in->flush();
+                return count;
+            }
+
+            // Do the only copy, this lets the writer continue while the readers are busy
+            auto block = pool->acquire(streams.size());
+            memcpy(block->data, base_type::_in->readBuf, count * sizeof(T));
+            base_type::_in->flush();
+
+            // Lend the block to every stream
+            for (int i = 0; i < streams.size(); i++) {
+                if (!streams[i]->swapShared(block, count)) {
+                    // The stream that failed already released its own reference, release the ones of the streams not reached
+                    for (int j = i + 1; j < streams.size(); j++) { buffer::SharedPool<T>::release(block); }
+                    return -1;
+                }
+            }
+
+            return count;
+        }
+
         std::vector<stream<T>*> streams;
+        buffer::SharedPool<T>* pool = NULL;
 
     };
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "scheduler.h"
+#include "block.h"
+
+namespace dsp {
+    enum {
+        TASK_IDLE,
+        TASK_QUEUED,
+        TASK_RUNNING,
+        TASK_NOTIFIED
+    };
+
+    // Index of the worker running on the current thread, -1 if not a worker
+    thread_local int currentWorker = -1;
+    thread_local block* currentTask = NULL;
+
+    Scheduler::Scheduler(int workerCount) {
+        _workerCount = workerCount;
+    }
+
+    Scheduler::~Scheduler() {
+        if (!started) { return; }
+
+        // Wake up and join all workers
+        {
+            std::lock_guard<std::mutex> lck(sleepMtx);
+            stopping = true;
+        }
+        sleepCV.notify_all();
+        for (auto& w : workers) {
+            if (w->thread.joinable()) { w->thread.join(); }
+            delete w;
+        }
+        workers.clear();
+    }
+
+    void Scheduler::add(block* task) {
+        // Start the workers on first use so that an unused scheduler costs nothing
+        if (!started) {
+            std::lock_guard<std::mutex> lck(startMtx);
+            if (!started) {
+                if (_workerCount <= 0) { _workerCount = std::max<int>(std::thread::hardware_concurrency(), 1); }
+                for (int i = 0; i < _workerCount; i++) { workers.push_back(new Worker); }
+                for (int i = 0; i < _workerCount; i++) { workers[i]->thread = std::thread(&Scheduler::worker, this, i); }
+                started = true;
+            }
+        }
+
+        task->schedEnabled = true;
+        notify(task);
+    }
+
+    void Scheduler::remove(block* task) {
+        task->schedEnabled = false;
+
+        // Wait for the task to be out of the queues and done running. A task can't wait for itself.
+        if (currentTask == task) { return; }
+        while (task->schedState != TASK_IDLE) { std::this_thread::yield(); }
+    }
+
+    int Scheduler::getWorkerCount() {
+        return _workerCount;
+    }
+
+    void Scheduler::wake(block* task) {
+        task->_scheduler->notify(task);
+    }
+
+    void Scheduler::notify(block* task) {
+        while (true) {
+            int state = task->schedState;
+            if (state == TASK_IDLE) {
+                if (task->schedState.compare_exchange_weak(state, TASK_QUEUED)) {
+                    push(task);
+                    return;
+                }
+            }
+            else if (state == TASK_RUNNING) {
+                // Have the worker running it check it again once done
+                if (task->schedState.compare_exchange_weak(state, TASK_NOTIFIED)) { return; }
+            }
+            else {
+                // Already queued or already flagged
+                return;
+            }
+        }
+    }
+
+    void Scheduler::push(block* task) {
+        // Keep tasks woken up by a worker on that worker for cache locality, spread the others
+        int id = (currentWorker >= 0) ? currentWorker : (pushIdx++ % _workerCount);
+        {
+            std::lock_guard<std::mutex> lck(workers[id]->queueMtx);
+            workers[id]->queue.push_back(task);
+        }
+
+        {
+            std::lock_guard<std::mutex> lck(sleepMtx);
+            pending++;
+        }
+        sleepCV.notify_one();
+    }
+
+    block* Scheduler::pop(int id) {
+        // Take the most recent task from our own queue
+        {
+            Worker* w = workers[id];
+            std::lock_guard<std::mutex> lck(w->queueMtx);
+            if (!w->queue.empty()) {
+                block* task = w->queue.back();
+                w->queue.pop_back();
+                return task;
+            }
+        }
+
+        // Otherwise steal the oldest task of another worker
+        for (int i = 1; i < _workerCount; i++) {
+            Worker* w = workers[(id + i) % _workerCount];
+            std::lock_guard<std::mutex> lck(w->queueMtx);
+            if (!w->queue.empty()) {
+                block* task = w->queue.front();
+                w->queue.pop_front();
+                return task;
+            }
+        }
+
+        return NULL;
+    }
+
+    void Scheduler::execute(block* task) {
+        task->schedState = TASK_RUNNING;
+        while (true) {
+            // Run the task once if it can do so without blocking, then requeue it to give other tasks a turn
+            if (task->schedEnabled && task->schedReady()) {
+                currentTask = task;
+                profiler::setCurrent(&task->counters);
+                task->profiledRun();
+                profiler::setCurrent(NULL);
+                currentTask = NULL;
+                task->schedState = TASK_QUEUED;
+                push(task);
+                return;
+            }
+
+            // Go idle unless something happened since the readiness check
+            int state = TASK_RUNNING;
+            if (task->schedState.compare_exchange_strong(state, TASK_IDLE)) { return; }
+            task->schedState = TASK_RUNNING;
+        }
+    }
+
+    void Scheduler::worker(int id) {
+        currentWorker = id;
+        while (true) {
+            block* task = pop(id);
+            if (!task) {
+                std::unique_lock<std::mutex> lck(sleepMtx);
+                sleepCV.wait(lck, [this] { return pending > 0 || stopping; });
+                if (stopping) { return; }
+                continue;
+            }
+            pending--;
+            execute(task);
+        }
+    }
+}
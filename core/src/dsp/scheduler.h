@@ -0,0 +1,54 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <condition_variable>
+
+namespace dsp {
+    class block;
+
+    // Fixed pool of worker threads running blocks as tasks instead of giving each block its own thread.
+    // A block scheduled on the pool is only run when all its inputs have data and all its outputs can
+    // accept a swap, so its run() never blocks. Each worker has its own queue, idle workers steal from
+    // the others. A scheduled block must read each input and swap each output at most once per run().
+    class Scheduler {
+    public:
+        // A worker count of 0 uses one worker per hardware thread
+        Scheduler(int workerCount = 0);
+        ~Scheduler();
+
+        void add(block* task);
+        void remove(block* task);
+
+        int getWorkerCount();
+
+        // Called by streams when an event that could make the task runnable happened
+        static void wake(block* task);
+
+    private:
+        struct Worker {
+            std::thread thread;
+            std::mutex queueMtx;
+            std::deque<block*> queue;
+        };
+
+        void notify(block* task);
+        void push(block* task);
+        block* pop(int id);
+        void execute(block* task);
+        void worker(int id);
+
+        int _workerCount;
+        std::vector<Worker*> workers;
+        std::mutex startMtx;
+        std::atomic<bool> started = { false };
+        std::atomic<bool> stopping = { false };
+        std::atomic<int> pushIdx = { 0 };
+
+        std::mutex sleepMtx;
+        std::condition_variable sleepCV;
+        std::atomic<int> pending = { 0 };
+    };
+}
@@ -0,0 +1,210 @@
+#pragma once
+#include "../sink.h"
+#include "../buffer/spsc_ring.h"
+#include "../multirate/polyphase_bank.h"
+#include "../taps/low_pass.h"
+
+// Number of phases of the fractional resampler, intermediate phases are interpolated linearly
+#define AUDIO_RING_PHASE_COUNT  128
+
+// Largest relative samplerate correction applied to follow the clock drift
+#define AUDIO_RING_MAX_DRIFT    0.005
+
+// Gains of the fill level control loop
+#define AUDIO_RING_KP           0.002
+#define AUDIO_RING_KI           0.00002
+
+namespace dsp::sink {
+    // Decouples the DSP chain from a real-time audio callback. Incoming audio is resampled by a ratio
+    // that is continuously adjusted to keep the ring at its target fill level, which compensates for
+    // the drift between the SDR clock and the sound card clock. The reader side never waits, missing
+    // samples are replaced by silence and counted as underruns, samples that don't fit are dropped
+    // and counted as overruns.
+    template <class T>
+    class AudioRing : public Sink<T> {
+        using base_type = Sink<T>;
+    public:
+        AudioRing() {}
+
+        AudioRing(stream<T>* in, int targetFill, int capacity) { init(in, targetFill, capacity); }
+
+        ~AudioRing() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(buffer);
+            buffer::free(resampBuf);
+            multirate::freePolyphaseBank(phases);
+        }
+
+        void init(stream<T>* in, int targetFill, int capacity) {
+            _targetFill = targetFill;
+            ring.init(capacity);
+
+            // Prototype filter of the fractional resampler, scaled back to unity gain per phase
+            tap<float> proto = taps::lowPass(0.45, 0.1, AUDIO_RING_PHASE_COUNT);
+            for (int i = 0; i < proto.size; i++) { proto.taps[i] *= (float)AUDIO_RING_PHASE_COUNT; }
+            phases = multirate::buildPolyphaseBank<float>(AUDIO_RING_PHASE_COUNT, proto);
+            taps::free(proto);
+
+            // Allocate the delay buffer with one extra sample of history for the interpolation
+            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + 64000);
+            bufStart = &buffer[phases.tapsPerPhase];
+            resampBuf = buffer::alloc<T>(STREAM_BUFFER_SIZE + 64000);
+            resetState();
+
+            base_type::init(in);
+        }
+
+        // Set the fill level, in samples, that the ring is regulated at, and its capacity
+        void setLatency(int targetFill, int capacity) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _targetFill = targetFill;
+            ring.init(capacity);
+            resetState();
+            base_type::tempStart();
+        }
+
+        // Non-blocking read for the audio callback, always fills the whole output
+        void read(T* out, int count) {
+            // Wait for the ring to be filled up to its target before playing anything
+            if (!primed) {
+                if (ring.getReadable() < _targetFill) {
+                    memset(out, 0, count * sizeof(T));
+                    return;
+                }
+                primed = true;
+            }
+
+            int got = ring.read(out, count);
+            if (got < count) {
+                memset(&out[got], 0, (count - got) * sizeof(T));
+                underruns++;
+                primed = false;
+            }
+        }
+
+        // Drop samples instead of playing them, for when the output is muted
+        void skip(int count) {
+            ring.skip(count);
+        }
+
+        // Current latency of the ring in samples
+        int getLatency() {
+            return ring.getReadable();
+        }
+
+        double getRatio() {
+            return ratio;
+        }
+
+        uint64_t getUnderruns() {
+            return underruns;
+        }
+
+        uint64_t getOverruns() {
+            return overruns;
+        }
+
+        void resetCounters() {
+            underruns = 0;
+            overruns = 0;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = resample(count, base_type::_in->readBuf, resampBuf);
+            base_type::_in->flush();
+
+            // Never wait for the reader, drop what doesn't fit
+            int written = ring.write(resampBuf, outCount);
+            if (written < outCount) { overruns++; }
+
+            updateRatio();
+
+            return count;
+        }
+
+    protected:
+        void resetState() {
+            buffer::clear<T>(buffer, phases.tapsPerPhase);
+            offset = 0;
+            frac = 0.0;
+            ratio = 1.0;
+            integral = 0.0;
+            avgFill = _targetFill;
+            primed = false;
+        }
+
+        inline T phaseOutput(const T* in, int phase) {
+            T out;
+            if constexpr (std::is_same_v<T, float>) {
+                volk_32f_x2_dot_prod_32f(&out, in, phases.phases[phase], phases.tapsPerPhase);
+            }
+            if constexpr (std::is_same_v<T, complex_t> || std::is_same_v<T, stereo_t>) {
+                volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out, (lv_32fc_t*)in, phases.phases[phase], phases.tapsPerPhase);
+            }
+            return out;
+        }
+
+        int resample(int count, const T* in, T* out) {
+            int outCount = 0;
+
+            // Copy input to buffer
+            memcpy(bufStart, in, count * sizeof(T));
+
+            while (offset < count) {
+                // Interpolate between the two nearest phases, the one after the last is the first of the next sample
+                double pos = frac * (double)AUDIO_RING_PHASE_COUNT;
+                int phase = (int)pos;
+                float mu = (float)(pos - (double)phase);
+                T a = phaseOutput(&buffer[offset], phase);
+                T b = (phase + 1 < AUDIO_RING_PHASE_COUNT) ? phaseOutput(&buffer[offset], phase + 1) : phaseOutput(&buffer[offset + 1], 0);
+                out[outCount++] = a * (1.0f - mu) + b * mu;
+
+                // Advance by the current ratio
+                frac += ratio;
+                int step = (int)frac;
+                offset += step;
+                frac -= (double)step;
+            }
+            offset -= count;
+
+            // Move delay
+            memmove(buffer, &buffer[count], phases.tapsPerPhase * sizeof(T));
+
+            return outCount;
+        }
+
+        void updateRatio() {
+            // Smooth out the fill level since the reader takes it out in bursts
+            avgFill = 0.95 * avgFill + 0.05 * (double)ring.getReadable();
+
+            // Consume the input faster when the ring is too full and slower when it's too empty
+            double error = (avgFill - (double)_targetFill) / (double)_targetFill;
+            integral = std::clamp<double>(integral + AUDIO_RING_KI * error, -AUDIO_RING_MAX_DRIFT, AUDIO_RING_MAX_DRIFT);
+            ratio = 1.0 + std::clamp<double>((AUDIO_RING_KP * error) + integral, -AUDIO_RING_MAX_DRIFT, AUDIO_RING_MAX_DRIFT);
+        }
+
+        buffer::SPSCRing<T> ring;
+        int _targetFill;
+
+        multirate::PolyphaseBank<float> phases;
+        T* buffer;
+        T* bufStart;
+        T* resampBuf;
+        int offset;
+        double frac;
+
+        std::atomic<double> ratio;
+        double integral;
+        double avgFill;
+
+        std::atomic<bool> primed;
+        std::atomic<uint64_t> underruns = { 0 };
+        std::atomic<uint64_t> overruns = { 0 };
+    };
+}
@@ -1,13 +1,23 @@
 #pragma once
 #include <string.h>
+#include <assert.h>
 #include <mutex>
+#include <atomic>
+#include <vector>
 #include <condition_variable>
 #include <volk/volk.h>
 #include "buffer/buffer.h"
+#include "buffer/shared_pool.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "../utils/trace.h"
 
 // 1MSample buffer
 #define STREAM_BUFFER_SIZE 1000000
 
+// Number of times a ring stream polls before going to sleep
+#define STREAM_RING_SPIN_COUNT 64
+
 namespace dsp {
     class untyped_stream {
     public:
@@ -19,14 +29,19 @@ namespace dsp {
         virtual void clearWriteStop() {}
         virtual void stopReader() {}
         virtual void clearReadStop() {}
+        virtual bool readable() { return false; }
+        virtual bool writable() { return false; }
+        virtual void setReaderTask(block* task) {}
+        virtual void setWriterTask(block* task) {}
     };
 
     template <class T>
     class stream : public untyped_stream {
     public:
+        using SharedBlock = typename buffer::SharedPool<T>::Block;
+
         stream() {
-            writeBuf = buffer::alloc<T>(STREAM_BUFFER_SIZE);
-            readBuf = buffer::alloc<T>(STREAM_BUFFER_SIZE);
+            allocBuffers();
         }
 
         virtual ~stream() {
@@ -34,58 +49,75 @@ namespace dsp {
         }
 
         virtual void setBufferSize(int samples) {
-            buffer::free(writeBuf);
-            buffer::free(readBuf);
-            writeBuf = buffer::alloc<T>(samples);
-            readBuf = buffer::alloc<T>(samples);
+            free();
+            bufferSize = samples;
+            allocBuffers();
         }
 
-        virtual inline bool swap(int size) {
-            {
-                // Wait to either swap or stop
-                std::unique_lock<std::mutex> lck(swapMtx);
-                swapCV.wait(lck, [this] { return (canSwap || writerStop); });
-
-                // If writer was stopped, abandon operation
-                if (writerStop) { return false; }
+        // Use a lock-free single-producer/single-consumer ring of `depth` buffers instead of the
+        // default double buffer, letting the writer run up to depth - 1 buffers ahead of the reader.
+        // A depth of 0 restores the default behavior. Must only be called while no block uses the stream.
+        virtual void setDepth(int depth) {
+            assert(depth == 0 || depth >= 2);
+            free();
+            _depth = depth;
+            allocBuffers();
+        }
 
-                // Swap buffers
-                dataSize = size;
-                T* temp = writeBuf;
-                writeBuf = readBuf;
-                readBuf = temp;
-                canSwap = false;
-            }
+        inline int getDepth() {
+            return _depth;
+        }
 
-            // Notify reader that some data is ready
-            {
-                std::lock_guard<std::mutex> lck(rdyMtx);
-                dataReady = true;
-            }
-            rdyCV.notify_all();
+        virtual inline bool swap(int size) {
+            TRACE_SCOPE("stream::swap");
+            if (_depth) { return ringSwap(size, NULL); }
+            return classicSwap(size, NULL);
+        }
 
-            return true;
+        // Publish a block of a shared pool instead of the write buffer. The reference held on the block
+        // is released once the reader flushed it, the reader must not modify its content.
+        virtual inline bool swapShared(SharedBlock* block, int size) {
+            TRACE_SCOPE("stream::swap");
+            if (_depth) { return ringSwap(size, block); }
+            return classicSwap(size, block);
         }
 
         virtual inline int read() {
+            TRACE_SCOPE("stream::read");
+            if (_depth) { return ringRead(); }
+
             // Wait for data to be ready or to be stopped
             std::unique_lock<std::mutex> lck(rdyMtx);
-            rdyCV.wait(lck, [this] { return (dataReady || readerStop); });
+            auto cond = [this] { return (dataReady || readerStop); };
+            if (!cond()) {
+                profiler::WaitTimer timer;
+                rdyCV.wait(lck, cond);
+            }
 
             return (readerStop ? -1 : dataSize);
         }
 
         virtual inline void flush() {
+            if (_depth) { ringFlush(); return; }
+
             // Clear data ready
             {
                 std::lock_guard<std::mutex> lck(rdyMtx);
                 dataReady = false;
             }
 
+            // Give back the shared block that was just read
+            if (readShared) {
+                buffer::SharedPool<T>::release(readShared);
+                readShared = NULL;
+                readBuf = ownReadBuf;
+            }
+
             // Notify writer that buffers can be swapped
             {
                 std::lock_guard<std::mutex> lck(swapMtx);
                 canSwap = true;
+                if (writerTask) { Scheduler::wake(writerTask); }
             }
 
             swapCV.notify_all();
@@ -115,9 +147,49 @@ namespace dsp {
             readerStop = false;
         }
 
+        // True if read() would return without waiting
+        virtual bool readable() {
+            if (_depth) { return head.load() != tail.load(); }
+            return dataReady;
+        }
+
+        // True if swap() would return without waiting
+        virtual bool writable() {
+            if (_depth) { return head.load() + 1 - tail.load() < (uint64_t)_depth; }
+            return canSwap;
+        }
+
+        // Set the scheduler task to wake up when data becomes available, NULL to disable
+        virtual void setReaderTask(block* task) {
+            std::lock_guard<std::mutex> lck(rdyMtx);
+            readerTask = task;
+        }
+
+        // Set the scheduler task to wake up when the stream can be swapped again, NULL to disable
+        virtual void setWriterTask(block* task) {
+            std::lock_guard<std::mutex> lck(swapMtx);
+            writerTask = task;
+        }
+
         void free() {
-            if (writeBuf) { buffer::free(writeBuf); }
-            if (readBuf) { buffer::free(readBuf); }
+            if (_depth) {
+                for (auto& block : slotShared) {
+                    if (block) { buffer::SharedPool<T>::release(block); }
+                }
+                for (auto& slot : slots) { buffer::free(slot); }
+                slots.clear();
+                slotSizes.clear();
+                slotShared.clear();
+            }
+            else {
+                if (readShared) {
+                    buffer::SharedPool<T>::release(readShared);
+                    readShared = NULL;
+                    readBuf = ownReadBuf;
+                }
+                if (writeBuf) { buffer::free(writeBuf); }
+                if (readBuf) { buffer::free(readBuf); }
+            }
             writeBuf = NULL;
             readBuf = NULL;
         }
@@ -126,17 +198,168 @@ namespace dsp {
         T* readBuf;
 
     private:
+        void allocBuffers() {
+            if (_depth) {
+                slots.resize(_depth);
+                slotSizes.resize(_depth);
+                slotShared.assign(_depth, NULL);
+                for (auto& slot : slots) { slot = buffer::alloc<T>(bufferSize); }
+                head = 0;
+                tail = 0;
+                writeBuf = slots[0];
+                readBuf = slots[0];
+            }
+            else {
+                writeBuf = buffer::alloc<T>(bufferSize);
+                readBuf = buffer::alloc<T>(bufferSize);
+            }
+        }
+
+        inline bool classicSwap(int size, SharedBlock* block) {
+            {
+                // Wait to either swap or stop
+                std::unique_lock<std::mutex> lck(swapMtx);
+                auto cond = [this] { return (canSwap || writerStop); };
+                if (!cond()) {
+                    profiler::WaitTimer timer;
+                    swapCV.wait(lck, cond);
+                }
+
+                // If writer was stopped, abandon operation
+                if (writerStop) {
+                    if (block) { buffer::SharedPool<T>::release(block); }
+                    return false;
+                }
+
+                // Swap buffers, or lend the shared block to the reader
+                dataSize = size;
+                if (block) {
+                    ownReadBuf = readBuf;
+                    readBuf = block->data;
+                    readShared = block;
+                }
+                else {
+                    T* temp = writeBuf;
+                    writeBuf = readBuf;
+                    readBuf = temp;
+                }
+                canSwap = false;
+            }
+
+            // Notify reader that some data is ready
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                dataReady = true;
+                if (readerTask) { Scheduler::wake(readerTask); }
+            }
+            rdyCV.notify_all();
+
+            return true;
+        }
+
+        inline bool ringSwap(int size, SharedBlock* block) {
+            // Wait for the slot after the one that was just written to be free or to be stopped. Nothing is
+            // published before that so that a stopped writer still owns the slot it is writing to.
+            uint64_t h = head.load(std::memory_order_relaxed);
+            auto cond = [this, h] { return (h + 1 - tail.load() < (uint64_t)_depth) || writerStop; };
+            if (!spinWait(cond)) {
+                profiler::WaitTimer timer;
+                std::unique_lock<std::mutex> lck(swapMtx);
+                writerWaiting.store(true);
+                swapCV.wait(lck, cond);
+                writerWaiting.store(false, std::memory_order_relaxed);
+            }
+
+            // If writer was stopped, abandon operation
+            if (writerStop) {
+                if (block) { buffer::SharedPool<T>::release(block); }
+                return false;
+            }
+
+            // Publish the slot that was just written and move on to the next one
+            slotSizes[h % _depth] = size;
+            slotShared[h % _depth] = block;
+            head.store(++h);
+            writeBuf = slots[h % _depth];
+            if (readerWaiting.load() || readerTask) {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                rdyCV.notify_all();
+                if (readerTask) { Scheduler::wake(readerTask); }
+            }
+
+            return true;
+        }
+
+        inline int ringRead() {
+            // Wait for data to be ready or to be stopped
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            auto cond = [this, t] { return (head.load() != t) || readerStop; };
+            if (!spinWait(cond)) {
+                profiler::WaitTimer timer;
+                std::unique_lock<std::mutex> lck(rdyMtx);
+                readerWaiting.store(true);
+                rdyCV.wait(lck, cond);
+                readerWaiting.store(false, std::memory_order_relaxed);
+            }
+
+            if (readerStop) { return -1; }
+
+            readBuf = slotShared[t % _depth] ? slotShared[t % _depth]->data : slots[t % _depth];
+            return slotSizes[t % _depth];
+        }
+
+        inline void ringFlush() {
+            // Release the slot that was just read
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            SharedBlock*& block = slotShared[t % _depth];
+            if (block) {
+                buffer::SharedPool<T>::release(block);
+                block = NULL;
+            }
+            tail.store(t + 1);
+            if (writerWaiting.load() || writerTask) {
+                std::lock_guard<std::mutex> lck(swapMtx);
+                swapCV.notify_all();
+                if (writerTask) { Scheduler::wake(writerTask); }
+            }
+        }
+
+        template <typename Func>
+        inline bool spinWait(Func cond) {
+            for (int i = 0; i < STREAM_RING_SPIN_COUNT; i++) {
+                if (cond()) { return true; }
+            }
+            return false;
+        }
+
         std::mutex swapMtx;
         std::condition_variable swapCV;
-        bool canSwap = true;
+        std::atomic<bool> canSwap = { true };
 
         std::mutex rdyMtx;
         std::condition_variable rdyCV;
-        bool dataReady = false;
+        std::atomic<bool> dataReady = { false };
 
-        bool readerStop = false;
-        bool writerStop = false;
+        // Scheduled blocks on each end, protected by rdyMtx and swapMtx respectively
+        std::atomic<block*> readerTask = { NULL };
+        std::atomic<block*> writerTask = { NULL };
+
+        std::atomic<bool> readerStop = { false };
+        std::atomic<bool> writerStop = { false };
 
         int dataSize = 0;
+        SharedBlock* readShared = NULL;
+        T* ownReadBuf = NULL;
+        int bufferSize = STREAM_BUFFER_SIZE;
+
+        // Ring mode
+        int _depth = 0;
+        std::vector<T*> slots;
+        std::vector<int> slotSizes;
+        std::vector<SharedBlock*> slotShared;
+        std::atomic<uint64_t> head = { 0 };
+        std::atomic<uint64_t> tail = { 0 };
+        std::atomic<bool> readerWaiting = { false };
+        std::atomic<bool> writerWaiting = { false };
     };
-}
\ No newline at end of file
+}
@@ -21,6 +21,7 @@
 #include <gui/menus/vfo_color.h>
 #include <gui/menus/module_manager.h>
 #include <gui/menus/theme.h>
+#include <gui/menus/dsp_profiler.h>
 #include <gui/dialogs/credits.h>
 #include <filesystem>
 #include <signal_path/source.h>
@@ -28,6 +29,7 @@
 #include <gui/colormaps.h>
 #include <gui/widgets/snr_meter.h>
 #include <gui/tuner.h>
+#include <utils/fft_plan.h>
 
 void MainWindow::init() {
     LoadingScreen::show("Initializing UI");
@@ -78,6 +80,7 @@ void MainWindow::init() {
     gui::menu.registerEntry("Theme", thememenu::draw, NULL);
     gui::menu.registerEntry("VFO Color", vfo_color_menu::draw, NULL);
     gui::menu.registerEntry("Module Manager", module_manager_menu::draw, NULL);
+    gui::menu.registerEntry("DSP Profiler", dsp_profiler_menu::draw, NULL);
 
     gui::freqSelect.init();
 
@@ -87,7 +90,7 @@ void MainWindow::init() {
 
     fft_in = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * fftSize);
     fft_out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * fftSize);
-    fftwPlan = fftwf_plan_dft_1d(fftSize, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
+    fftwPlan = fftplan::createEstimate(fftSize, fft_in, fft_out, FFTW_FORWARD);
 
     sigpath::iqFrontEnd.init(&dummyStream, 8000000, true, 1, false, 1024, 20.0, IQFrontEnd::FFTWindow::NUTTALL, acquireFFTBuffer, releaseFFTBuffer, this);
     sigpath::iqFrontEnd.start();
@@ -170,6 +173,7 @@ void MainWindow::init() {
     displaymenu::init();
     vfo_color_menu::init();
     module_manager_menu::init();
+    dsp_profiler_menu::init();
 
     // TODO for 0.2.5
     // Fix gain not updated on startup, soapysdr
@@ -0,0 +1,136 @@
+#include <gui/menus/dsp_profiler.h>
+#include <imgui.h>
+#include <core.h>
+#include <gui/style.h>
+#include <dsp/profiler.h>
+#include <utils/flog.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <vector>
+
+// Time between two updates of the table, in nanoseconds
+#define PROFILER_MENU_UPDATE_INTERVAL   1000000000
+
+namespace dsp_profiler_menu {
+    struct Row {
+        std::string name;
+        bool scheduled;
+        double msps;
+        double busy;
+        double wait;
+        double cpu;
+    };
+
+    bool enabled = false;
+    std::map<const void*, dsp::profiler::BlockStats> lastStats;
+    uint64_t lastUpdate = 0;
+    std::vector<Row> rows;
+    double totalCpu = 0.0;
+
+    void init() {
+        enabled = dsp::profiler::isEnabled();
+    }
+
+    void update() {
+        uint64_t now = dsp::profiler::now();
+        double dt = (double)(now - lastUpdate);
+        auto stats = dsp::profiler::getStats();
+
+        // Compute the rates over the last interval, blocks that just appeared are shown on the next one
+        rows.clear();
+        totalCpu = 0.0;
+        std::map<const void*, dsp::profiler::BlockStats> newStats;
+        for (auto& s : stats) {
+            newStats[s.id] = s;
+            auto it = lastStats.find(s.id);
+            if (it == lastStats.end() || !lastUpdate) { continue; }
+            auto& l = it->second;
+
+            Row r;
+            r.name = s.name;
+            r.scheduled = s.scheduled;
+            r.msps = (double)(s.samples - l.samples) * 1000.0 / dt;
+            r.wait = 100.0 * (double)(s.waitNs - l.waitNs) / dt;
+            r.busy = std::max<double>(100.0 * (double)(s.runNs - l.runNs) / dt - r.wait, 0.0);
+            r.cpu = 100.0 * (double)(s.cpuNs - l.cpuNs) / dt;
+            totalCpu += r.cpu;
+            rows.push_back(r);
+        }
+        lastStats = newStats;
+        lastUpdate = now;
+
+        // Biggest CPU users first
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.cpu > b.cpu; });
+    }
+
+    void saveDump() {
+        std::string path = (std::string)core::args["root"] + "/dsp_profile.json";
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            flog::error("Could not write DSP profile to '{0}'", path);
+            return;
+        }
+        file << dsp::profiler::dump();
+        flog::info("DSP profile written to '{0}'", path);
+    }
+
+    void draw(void* ctx) {
+        if (ImGui::Checkbox("Enabled##_dsp_prof_en", &enabled)) {
+            dsp::profiler::setEnabled(enabled);
+            lastStats.clear();
+            lastUpdate = 0;
+            rows.clear();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Save dump##_dsp_prof_dump")) {
+            saveDump();
+        }
+
+        if (!enabled) {
+            ImGui::TextDisabled("Enable to collect per-block statistics");
+            return;
+        }
+
+        // Refresh periodically so the numbers are readable
+        if (dsp::profiler::now() - lastUpdate >= PROFILER_MENU_UPDATE_INTERVAL) {
+            update();
+        }
+
+        ImGui::Text("Total CPU: %.1f%%", totalCpu);
+
+        if (ImGui::BeginTable("DSP Profiler Table", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 300.0f * style::uiScale))) {
+            ImGui::TableSetupColumn("Block");
+            ImGui::TableSetupColumn("MS/s");
+            ImGui::TableSetupColumn("Busy");
+            ImGui::TableSetupColumn("Wait");
+            ImGui::TableSetupColumn("CPU");
+            ImGui::TableSetupScrollFreeze(5, 1);
+            ImGui::TableHeadersRow();
+
+            for (auto& r : rows) {
+                ImGui::TableNextRow();
+
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(r.name.c_str());
+                if (ImGui::IsItemHovered()) {
+                    ImGui::SetTooltip("%s%s", r.name.c_str(), r.scheduled ? " (scheduled)" : "");
+                }
+
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.3f", r.msps);
+
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%.1f%%", r.busy);
+
+                ImGui::TableSetColumnIndex(3);
+                ImGui::Text("%.1f%%", r.wait);
+
+                ImGui::TableSetColumnIndex(4);
+                ImGui::Text("%.1f%%", r.cpu);
+            }
+
+            ImGui::EndTable();
+        }
+    }
+}
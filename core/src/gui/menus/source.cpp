@@ -20,6 +20,8 @@ namespace sourcemenu {
 
     bool iqCorrection = false;
     bool invertIQ = false;
+    bool channelizer = false;
+    bool dspScheduler = false;
 
     int offsetId = 0;
     double manualOffset = 0.0;
@@ -176,6 +178,8 @@ namespace sourcemenu {
         std::string selectedOffset = core::configManager.conf["selectedOffset"];
         iqCorrection = core::configManager.conf["iqCorrection"];
         invertIQ = core::configManager.conf["invertIQ"];
+        channelizer = core::configManager.conf["channelizer"];
+        dspScheduler = core::configManager.conf["dspScheduler"];
         int decimation = core::configManager.conf["decimation"];
         if (decimations.keyExists(decimation)) {
             decimId = decimations.keyId(decimation);
@@ -192,6 +196,8 @@ namespace sourcemenu {
         sigpath::iqFrontEnd.setDCBlocking(iqCorrection);
         sigpath::iqFrontEnd.setInvertIQ(invertIQ);
         sigpath::iqFrontEnd.setDecimation(decimations.value(decimId));
+        sigpath::iqFrontEnd.setChannelizer(channelizer);
+        sigpath::iqFrontEnd.setScheduler(dspScheduler ? &sigpath::dspScheduler : NULL);
         selectOffsetByName(selectedOffset);
 
         // Register handlers
@@ -315,6 +321,20 @@ namespace sourcemenu {
             core::configManager.release(true);
         }
 
+        if (ImGui::Checkbox("Shared Channelizer##_sdrpp_channelizer", &channelizer)) {
+            sigpath::iqFrontEnd.setChannelizer(channelizer);
+            core::configManager.acquire();
+            core::configManager.conf["channelizer"] = channelizer;
+            core::configManager.release(true);
+        }
+
+        if (ImGui::Checkbox("DSP Thread Pool##_sdrpp_dsp_sched", &dspScheduler)) {
+            sigpath::iqFrontEnd.setScheduler(dspScheduler ? &sigpath::dspScheduler : NULL);
+            core::configManager.acquire();
+            core::configManager.conf["dspScheduler"] = dspScheduler;
+            core::configManager.release(true);
+        }
+
         ImGui::LeftLabel("Offset mode");
         ImGui::SetNextItemWidth(itemWidth - ImGui::GetCursorPosX() - 2.0f*(lineHeight + 1.5f*spacing));
         if (ImGui::Combo("##_sdrpp_offset", &offsetId, offsets.txt)) {
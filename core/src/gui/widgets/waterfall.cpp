@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <volk/volk.h>
 #include <utils/flog.h>
+#include <utils/trace.h>
 #include <gui/gui.h>
 #include <gui/style.h>
 
@@ -211,8 +212,14 @@ namespace ImGui {
             updateWaterfallTexture();
         }
         {
+            // The texture is circular, draw from the newest line to the bottom of the texture then wrap around
             std::lock_guard<std::mutex> lck(texMtx);
-            window->DrawList->AddImage((void*)(intptr_t)textureId, wfMin, wfMax);
+            float split = (float)currentFFTLine / (float)waterfallHeight;
+            float splitY = wfMin.y + (waterfallHeight - currentFFTLine);
+            window->DrawList->AddImage((void*)(intptr_t)textureId, wfMin, ImVec2(wfMax.x, splitY), ImVec2(0.0f, split), ImVec2(1.0f, 1.0f));
+            if (currentFFTLine) {
+                window->DrawList->AddImage((void*)(intptr_t)textureId, ImVec2(wfMin.x, splitY), wfMax, ImVec2(0.0f, 0.0f), ImVec2(1.0f, split));
+            }
         }
         
         ImVec2 mPos = ImGui::GetMousePos();
@@ -613,20 +620,23 @@ namespace ImGui {
             for (int i = 0; i < count; i++) {
                 drawDataSize = (viewBandwidth / wholeBandwidth) * rawFFTSize;
                 drawDataStart = (((double)rawFFTSize / 2.0) * (offsetRatio + 1)) - (drawDataSize / 2);
-                doZoom(drawDataStart, drawDataSize, rawFFTSize, dataWidth, &rawFFTs[((i + currentFFTLine) % waterfallHeight) * rawFFTSize], tempData);
+                int line = (i + currentFFTLine) % waterfallHeight;
+                zoomLine(line, drawDataStart, drawDataSize, tempData);
                 for (int j = 0; j < dataWidth; j++) {
                     pixel = (std::clamp<float>(tempData[j], waterfallMin, waterfallMax) - waterfallMin) / dataRange;
-                    waterfallFb[(i * dataWidth) + j] = waterfallPallet[(int)(pixel * (WATERFALL_RESOLUTION - 1))];
+                    waterfallFb[(line * dataWidth) + j] = waterfallPallet[(int)(pixel * (WATERFALL_RESOLUTION - 1))];
                 }
             }
 
             for (int i = count; i < waterfallHeight; i++) {
+                int line = (i + currentFFTLine) % waterfallHeight;
                 for (int j = 0; j < dataWidth; j++) {
-                    waterfallFb[(i * dataWidth) + j] = (uint32_t)255 << 24;
+                    waterfallFb[(line * dataWidth) + j] = (uint32_t)255 << 24;
                 }
             }
         }
         delete[] tempData;
+        waterfallFullUpdate = true;
         waterfallUpdate = true;
     }
 
@@ -707,7 +717,71 @@ namespace ImGui {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dataWidth, waterfallHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, (uint8_t*)waterfallFb);
+
+        // Upload everything after a redraw or resize
+        if (waterfallFullUpdate || waterfallPendingLines >= waterfallHeight) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, dataWidth, waterfallHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, (uint8_t*)waterfallFb);
+            waterfallFullUpdate = false;
+            waterfallPendingLines = 0;
+            return;
+        }
+
+        // Otherwise only upload the new lines, in two parts if they wrap around the end of the texture
+        int first = std::min<int>(waterfallPendingLines, waterfallHeight - currentFFTLine);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, currentFFTLine, dataWidth, first, GL_RGBA, GL_UNSIGNED_BYTE, (uint8_t*)&waterfallFb[currentFFTLine * dataWidth]);
+        if (first < waterfallPendingLines) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, dataWidth, waterfallPendingLines - first, GL_RGBA, GL_UNSIGNED_BYTE, (uint8_t*)waterfallFb);
+        }
+        waterfallPendingLines = 0;
+    }
+
+    void WaterFall::allocPyramid() {
+        // Compute the size and position of each level within a line
+        pyramidSizes.clear();
+        pyramidOffsets.clear();
+        pyramidStride = 0;
+        for (int size = (rawFFTSize + 1) / 2; size >= WATERFALL_PYRAMID_MIN_SIZE; size = (size + 1) / 2) {
+            pyramidSizes.push_back(size);
+            pyramidOffsets.push_back(pyramidStride);
+            pyramidStride += size;
+        }
+
+        int lines = std::max<int>(1, waterfallHeight);
+        if (fftPyramid != NULL) {
+            fftPyramid = (float*)realloc(fftPyramid, std::max<int>(1, lines * pyramidStride) * sizeof(float));
+        }
+        else {
+            fftPyramid = (float*)malloc(std::max<int>(1, lines * pyramidStride) * sizeof(float));
+        }
+        memset(fftPyramid, 0, lines * pyramidStride * sizeof(float));
+    }
+
+    void WaterFall::buildPyramid(int line) {
+        // Each bin of a level is the max of two bins of the previous one
+        float* in = &rawFFTs[line * rawFFTSize];
+        float* out = &fftPyramid[line * pyramidStride];
+        int inSize = rawFFTSize;
+        for (int size : pyramidSizes) {
+            for (int i = 0; i < inSize / 2; i++) {
+                out[i] = std::max<float>(in[2 * i], in[(2 * i) + 1]);
+            }
+            if (inSize & 1) { out[size - 1] = in[inSize - 1]; }
+            in = out;
+            out += size;
+            inSize = size;
+        }
+    }
+
+    void WaterFall::zoomLine(int line, int offset, int width, float* out) {
+        // Use the most decimated level that still has at least one bin per pixel
+        int level = 0;
+        while (level < pyramidSizes.size() && (width >> (level + 1)) >= dataWidth) { level++; }
+        if (!level) {
+            doZoom(offset, width, rawFFTSize, dataWidth, &rawFFTs[line * rawFFTSize], out);
+            return;
+        }
+        float* in = &fftPyramid[(line * pyramidStride) + pyramidOffsets[level - 1]];
+        doZoom(offset >> level, width >> level, pyramidSizes[level - 1], dataWidth, in, out);
     }
 
     void WaterFall::onPositionChange() {
@@ -753,6 +827,10 @@ namespace ImGui {
             else {
                 rawFFTs = (float*)malloc(waterfallHeight * rawFFTSize * sizeof(float));
             }
+
+            // The lines were moved around, decimate them again
+            allocPyramid();
+            for (int i = 0; i < fftLines; i++) { buildPyramid(i); }
             // ==============
         }
 
@@ -781,6 +859,7 @@ namespace ImGui {
             delete[] waterfallFb;
             waterfallFb = new uint32_t[dataWidth * waterfallHeight];
             memset(waterfallFb, 0, dataWidth * waterfallHeight * sizeof(uint32_t));
+            waterfallFullUpdate = true;
         }
         for (int i = 0; i < dataWidth; i++) {
             latestFFT[i] = -1000.0f; // Hide everything
@@ -887,6 +966,7 @@ namespace ImGui {
     }
 
     void WaterFall::pushFFT() {
+        TRACE_SCOPE("WaterFall::pushFFT");
         if (rawFFTs == NULL) { return; }
         std::lock_guard<std::recursive_mutex> lck(latestFFTMtx);
         double offsetRatio = viewOffset / (wholeBandwidth / 2.0);
@@ -894,19 +974,22 @@ namespace ImGui {
         int drawDataStart = (((double)rawFFTSize / 2.0) * (offsetRatio + 1)) - (drawDataSize / 2);
 
         if (waterfallVisible) {
-            doZoom(drawDataStart, drawDataSize, rawFFTSize, dataWidth, &rawFFTs[currentFFTLine * rawFFTSize], latestFFT);
-            memmove(&waterfallFb[dataWidth], waterfallFb, dataWidth * (waterfallHeight - 1) * sizeof(uint32_t));
+            buildPyramid(currentFFTLine);
+            zoomLine(currentFFTLine, drawDataStart, drawDataSize, latestFFT);
             float pixel;
             float dataRange = waterfallMax - waterfallMin;
+            uint32_t* line = &waterfallFb[currentFFTLine * dataWidth];
             for (int j = 0; j < dataWidth; j++) {
                 pixel = (std::clamp<float>(latestFFT[j], waterfallMin, waterfallMax) - waterfallMin) / dataRange;
                 int id = (int)(pixel * (WATERFALL_RESOLUTION - 1));
-                waterfallFb[j] = waterfallPallet[id];
+                line[j] = waterfallPallet[id];
             }
+            waterfallPendingLines = std::min<int>(waterfallPendingLines + 1, waterfallHeight);
             waterfallUpdate = true;
         }
         else {
-            doZoom(drawDataStart, drawDataSize, rawFFTSize, dataWidth, rawFFTs, latestFFT);
+            buildPyramid(0);
+            zoomLine(0, drawDataStart, drawDataSize, latestFFT);
             fftLines = 1;
         }
 
@@ -1143,6 +1226,7 @@ namespace ImGui {
         }
         fftLines = 0;
         memset(rawFFTs, 0, rawFFTSize * waterfallHeight * sizeof(float));
+        allocPyramid();
         updateWaterfallFb();
     }
 
@@ -1389,6 +1473,7 @@ namespace ImGui {
         waterfallVisible = true;
         onResize();
         memset(rawFFTs, 0, waterfallHeight * rawFFTSize * sizeof(float));
+        memset(fftPyramid, 0, waterfallHeight * pyramidStride * sizeof(float));
         updateWaterfallFb();
         buf_mtx.unlock();
     }
@@ -10,6 +10,9 @@
 
 #define WATERFALL_RESOLUTION 1000000
 
+// Smallest level of the decimated FFT history, below the narrowest possible waterfall
+#define WATERFALL_PYRAMID_MIN_SIZE  32
+
 namespace ImGui {
     class WaterfallVFO {
     public:
@@ -228,10 +231,15 @@ namespace ImGui {
         void onResize();
         void updateWaterfallFb();
         void updateWaterfallTexture();
+        void allocPyramid();
+        void buildPyramid(int line);
+        void zoomLine(int line, int offset, int width, float* out);
         void updateAllVFOs(bool checkRedrawRequired = false);
         bool calculateVFOSignalInfo(float* fftLine, WaterfallVFO* vfo, float& strength, float& snr);
 
         bool waterfallUpdate = false;
+        bool waterfallFullUpdate = true; // Whole texture needs to be uploaded again
+        int waterfallPendingLines = 0;   // Number of new lines to upload starting at currentFFTLine
 
         uint32_t waterfallPallet[WATERFALL_RESOLUTION];
 
@@ -282,7 +290,7 @@ namespace ImGui {
         float waterfallMax;
 
         //std::vector<std::vector<float>> rawFFTs;
-        int rawFFTSize;
+        int rawFFTSize = 0;
         float* rawFFTs = NULL;
         float* latestFFT = NULL;
         float* latestFFTHold = NULL;
@@ -290,7 +298,13 @@ namespace ImGui {
         int currentFFTLine = 0;
         int fftLines = 0;
 
-        uint32_t* waterfallFb;
+        // Max-decimated copies of each line of rawFFTs, each level half the size of the previous one
+        float* fftPyramid = NULL;
+        int pyramidStride = 0;
+        std::vector<int> pyramidSizes;
+        std::vector<int> pyramidOffsets;
+
+        uint32_t* waterfallFb; // Circular like rawFFTs, line i of the display is at (i + currentFFTLine) % waterfallHeight
 
         bool draggingFW = false;
         int FFTAreaHeight;
@@ -0,0 +1,224 @@
+#include "headless.h"
+#include "core.h"
+#include <utils/flog.h>
+#include <utils/fft_plan.h>
+#include <utils/trace.h>
+#include <config.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <signal_path/signal_path.h>
+#include <gui/gui.h>
+
+namespace headless {
+    dsp::stream<dsp::complex_t> dummyStream;
+    EventHandler<VFOManager::VFO*> vfoCreatedHandler;
+    std::atomic<bool> exitRequested = { false };
+
+    void signalHandler(int sig) {
+        exitRequested = true;
+    }
+
+    void vfoCreated(VFOManager::VFO* vfo, void* ctx) {
+        // Restore the offset saved for this VFO, if any
+        std::string name = vfo->getName();
+        core::configManager.acquire();
+        if (!core::configManager.conf["vfoOffsets"].contains(name)) {
+            core::configManager.release();
+            return;
+        }
+        double offset = core::configManager.conf["vfoOffsets"][name];
+        core::configManager.release();
+        sigpath::vfoManager.setCenterOffset(name, offset);
+    }
+
+    bool loadConfig(const std::string& path) {
+        // Parse the headless config
+        if (!std::filesystem::is_regular_file(path)) {
+            flog::error("Headless config {0} does not exist", path);
+            return false;
+        }
+        json conf;
+        try {
+            std::ifstream file(path);
+            file >> conf;
+        }
+        catch (const std::exception& e) {
+            flog::error("Could not parse headless config {0}: {1}", path, e.what());
+            return false;
+        }
+        if (!conf.is_object()) {
+            flog::error("Headless config {0} is not a JSON object", path);
+            return false;
+        }
+
+        // The overrides only live in memory so that the config of the GUI is left untouched
+        core::configManager.disableAutoSave();
+        core::configManager.acquire();
+        for (auto const& [key, val] : conf.items()) {
+            if (!core::configManager.conf.contains(key)) {
+                flog::warn("Unknown key in headless config {0}, ignoring", key);
+                continue;
+            }
+            core::configManager.conf[key] = val;
+        }
+        core::configManager.release();
+        return true;
+    }
+
+    void loadModules() {
+        core::configManager.acquire();
+        std::string modulesDir = core::configManager.conf["modulesDirectory"];
+        std::vector<std::string> modules = core::configManager.conf["modules"];
+        auto modList = core::configManager.conf["moduleInstances"].items();
+        core::configManager.release();
+        modulesDir = std::filesystem::absolute(modulesDir).string();
+
+        // Load modules from the module directory
+        flog::info("Loading modules");
+        if (std::filesystem::is_directory(modulesDir)) {
+            for (const auto& file : std::filesystem::directory_iterator(modulesDir)) {
+                std::string path = file.path().generic_string();
+                if (file.path().extension().generic_string() != SDRPP_MOD_EXTENTSION) {
+                    continue;
+                }
+                if (!file.is_regular_file()) { continue; }
+                flog::info("Loading {0}", path);
+                core::moduleManager.loadModule(path);
+            }
+        }
+        else {
+            flog::warn("Module directory {0} does not exist, not loading modules from directory", modulesDir);
+        }
+
+        // Load additional modules specified through config
+        for (auto const& path : modules) {
+            std::string apath = std::filesystem::absolute(path).string();
+            flog::info("Loading {0}", apath);
+            core::moduleManager.loadModule(apath);
+        }
+
+        // Create module instances, only the ones listed are created so GUI only modules can simply be left out
+        for (auto const& [name, _module] : modList) {
+            std::string mod = _module["module"];
+            bool enabled = _module["enabled"];
+            if (core::moduleManager.modules.find(mod) == core::moduleManager.modules.end()) {
+                flog::warn("Module {0} needed by {1} isn't loaded, skipping", mod, name);
+                continue;
+            }
+            flog::info("Initializing {0} ({1})", name, mod);
+            core::moduleManager.createInstance(name, mod);
+            if (!enabled) { core::moduleManager.disableInstance(name); }
+        }
+    }
+
+    void setupFrontEnd() {
+        core::configManager.acquire();
+        std::string sourceName = core::configManager.conf["source"];
+        bool iqCorrection = core::configManager.conf["iqCorrection"];
+        bool invertIQ = core::configManager.conf["invertIQ"];
+        bool channelizer = core::configManager.conf["channelizer"];
+        bool dspScheduler = core::configManager.conf["dspScheduler"];
+        int decimation = core::configManager.conf["decimation"];
+        std::string selectedOffset = core::configManager.conf["selectedOffset"];
+        double offset = 0.0;
+        if (selectedOffset == "Manual") {
+            offset = core::configManager.conf["manualOffset"];
+        }
+        else if (core::configManager.conf["offsets"].contains(selectedOffset)) {
+            offset = core::configManager.conf["offsets"][selectedOffset];
+        }
+        core::configManager.release();
+
+        // Select the source, falling back to the first one like the GUI does
+        auto sources = sigpath::sourceManager.getSourceNames();
+        if (sources.empty()) {
+            flog::warn("No source available");
+        }
+        else if (std::find(sources.begin(), sources.end(), sourceName) == sources.end()) {
+            flog::warn("Source {0} not found, using {1} instead", sourceName, sources[0]);
+            sigpath::sourceManager.selectSource(sources[0]);
+        }
+        else {
+            sigpath::sourceManager.selectSource(sourceName);
+        }
+
+        // Same decimation ratios as offered by the GUI
+        if (decimation < 1 || decimation > 64 || (decimation & (decimation - 1))) {
+            flog::warn("Invalid decimation {0}, disabling decimation", decimation);
+            decimation = 1;
+        }
+
+        sigpath::iqFrontEnd.setDCBlocking(iqCorrection);
+        sigpath::iqFrontEnd.setInvertIQ(invertIQ);
+        sigpath::iqFrontEnd.setDecimation(decimation);
+        sigpath::iqFrontEnd.setChannelizer(channelizer);
+        sigpath::iqFrontEnd.setScheduler(dspScheduler ? &sigpath::dspScheduler : NULL);
+        sigpath::sourceManager.setTuningOffset(offset);
+    }
+
+    int main(const std::string& configPath) {
+        flog::info("=====| HEADLESS MODE |=====");
+
+        if (!loadConfig(configPath)) { return -1; }
+
+        // The waterfall object is never drawn but still holds the center frequency and VFO geometry read by modules
+        gui::waterfall.setBandwidth(8000000);
+        gui::waterfall.setViewBandwidth(8000000);
+
+        // Init the IQ front end without its FFT, nothing would ever read it
+        sigpath::iqFrontEnd.setFFTEnabled(false);
+        sigpath::iqFrontEnd.init(&dummyStream, 8000000, true, 1, false, 1024, 20.0, IQFrontEnd::FFTWindow::NUTTALL, NULL, NULL, NULL);
+        sigpath::iqFrontEnd.start();
+
+        vfoCreatedHandler.handler = vfoCreated;
+        vfoCreatedHandler.ctx = NULL;
+        sigpath::vfoManager.onVfoCreated.bindHandler(&vfoCreatedHandler);
+
+        // Menu entries registered by the modules are kept but never drawn
+        loadModules();
+        setupFrontEnd();
+
+        core::configManager.acquire();
+        sigpath::sinkManager.loadSinksFromConfig();
+        double frequency = core::configManager.conf["frequency"];
+        core::configManager.release();
+
+        gui::waterfall.setCenterFrequency(frequency);
+        sigpath::sourceManager.tune(frequency);
+
+        core::moduleManager.doPostInitAll();
+
+        // Start the source through the main window so that modules waiting on the play state are notified
+        std::signal(SIGINT, signalHandler);
+        std::signal(SIGTERM, signalHandler);
+        gui::mainWindow.setPlayState(true);
+
+        flog::info("Ready, running until interrupted");
+        while (!exitRequested) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        flog::info("Stopping");
+        gui::mainWindow.setPlayState(false);
+        for (auto& [name, mod] : core::moduleManager.modules) {
+            mod.end();
+        }
+        sigpath::iqFrontEnd.stop();
+        fftplan::end();
+
+#ifdef SDRPP_TRACING
+        std::string tracePath = (std::string)core::args["trace"];
+        if (!tracePath.empty()) {
+            trace::stop();
+            trace::dump(tracePath);
+        }
+#endif
+
+        flog::info("Exiting successfully");
+        return 0;
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <string>
+
+// Runs the source, VFOs and every module instance without any GUI, no ImGui or OpenGL context is
+// created and the FFT of the IQ front end is disabled. The JSON file uses the same keys as config.json
+// and overrides them for this run only, the main config is never written in this mode.
+namespace headless {
+    int main(const std::string& configPath);
+}
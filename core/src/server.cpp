@@ -8,62 +8,38 @@
 #include <signal_path/signal_path.h>
 #include <gui/smgui.h>
 #include <utils/optionlist.h>
-#include "dsp/compression/sample_stream_compressor.h"
-#include "dsp/sink/handler_sink.h"
-#include <zstd.h>
+#include "dsp/routing/splitter.h"
 
 namespace server {
     dsp::stream<dsp::complex_t> dummyInput;
-    dsp::compression::SampleStreamCompressor comp;
-    dsp::sink::Handler<uint8_t> hnd;
-    net::Conn client;
-    uint8_t* rbuf = NULL;
-    uint8_t* sbuf = NULL;
-    uint8_t* bbuf = NULL;
-
-    PacketHeader* r_pkt_hdr = NULL;
-    uint8_t* r_pkt_data = NULL;
-    CommandHeader* r_cmd_hdr = NULL;
-    uint8_t* r_cmd_data = NULL;
-
-    PacketHeader* s_pkt_hdr = NULL;
-    uint8_t* s_pkt_data = NULL;
-    CommandHeader* s_cmd_hdr = NULL;
-    uint8_t* s_cmd_data = NULL;
-
-    PacketHeader* bb_pkt_hdr = NULL;
-    uint8_t* bb_pkt_data = NULL;
+    dsp::routing::Splitter<dsp::complex_t> splitter;
 
     SmGui::DrawListElem dummyElem;
 
-    ZSTD_CCtx* cctx;
-
     net::Listener listener;
 
+    // Sessions are only added, removed or reconfigured with this held
+    std::recursive_mutex sessionsMtx;
+    std::vector<Session*> sessions;
+    int nextSessionId = 0;
+    int runningSessions = 0;
+
     OptionList<std::string, std::string> sourceList;
     int sourceId = 0;
     bool running = false;
-    bool compression = false;
     double sampleRate = 1000000.0;
+    double frequency = 0.0;
 
-    int main() {
-        flog::info("=====| SERVER MODE |=====");
+    Session::Session(int id, net::Conn conn) {
+        this->id = id;
+        this->conn = std::move(conn);
 
-        // Init DSP
-        comp.init(&dummyInput, dsp::compression::PCM_TYPE_I8);
-        hnd.init(&comp.out, _testServerHandler, NULL);
+        // Allocate buffers
         rbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
         sbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
         bbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
-        comp.start();
-        hnd.start();
 
         // Initialize headers
-        r_pkt_hdr = (PacketHeader*)rbuf;
-        r_pkt_data = &rbuf[sizeof(PacketHeader)];
-        r_cmd_hdr = (CommandHeader*)r_pkt_data;
-        r_cmd_data = &rbuf[sizeof(PacketHeader) + sizeof(CommandHeader)];
-
         s_pkt_hdr = (PacketHeader*)sbuf;
         s_pkt_data = &sbuf[sizeof(PacketHeader)];
         s_cmd_hdr = (CommandHeader*)s_pkt_data;
@@ -72,8 +48,59 @@ namespace server {
         bb_pkt_hdr = (PacketHeader*)bbuf;
         bb_pkt_data = &bbuf[sizeof(PacketHeader)];
 
-        // Initialize compressor
+        // Init DSP, the DDC is only inserted when a channel is requested
+        ddc.init(&input, sampleRate, sampleRate, sampleRate, 0.0);
+        comp.init(&input, dsp::compression::PCM_TYPE_I16);
+        hnd.init(&comp.out, _testServerHandler, this);
+
+        // Initialize compressor, it's fine if zstd was built without multithreading
         cctx = ZSTD_createCCtx();
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, SERVER_DEFAULT_COMPRESSION_LEVEL);
+        size_t err = ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, SERVER_COMPRESSION_WORKERS);
+        if (ZSTD_isError(err)) { flog::warn("Multithreaded compression not available: {0}", ZSTD_getErrorName(err)); }
+
+        // Allocate the send queue and start the sender
+        for (int i = 0; i < SERVER_SEND_QUEUE_SIZE; i++) {
+            SendBlock* block = new SendBlock;
+            block->data = new uint8_t[STREAM_BUFFER_SIZE * sizeof(dsp::complex_t) + 8];
+            block->size = 0;
+            freeBlocks.push_back(block);
+        }
+        sendThread = std::thread(_sendWorker, this);
+    }
+
+    Session::~Session() {
+        hnd.stop();
+        comp.stop();
+        ddc.stop();
+
+        // Stop the sender
+        {
+            std::lock_guard<std::mutex> lck(queueMtx);
+            stopSender = true;
+        }
+        queueCnd.notify_all();
+        if (sendThread.joinable()) { sendThread.join(); }
+        for (auto& block : pendingBlocks) { freeBlocks.push_back(block); }
+        for (auto& block : freeBlocks) {
+            delete[] block->data;
+            delete block;
+        }
+
+        if (conn) { conn->close(); }
+        ZSTD_freeCCtx(cctx);
+        delete[] rbuf;
+        delete[] sbuf;
+        delete[] bbuf;
+    }
+
+    int main() {
+        flog::info("=====| SERVER MODE |=====");
+
+        // Init DSP, every client reads the same buffers from the splitter
+        splitter.init(&dummyInput);
+        splitter.setShared(true);
+        splitter.start();
 
         // Load config
         core::configManager.acquire();
@@ -155,52 +182,36 @@ namespace server {
         listener->acceptAsync(_clientHandler, NULL);
 
         flog::info("Ready, listening on {0}:{1}", host, port);
-        while(1) { std::this_thread::sleep_for(std::chrono::milliseconds(100)); }
-
-        return 0;
-    }
-
-    void _clientHandler(net::Conn conn, void* ctx) {
-        // Reject if someone else is already connected
-        if (client && client->isOpen()) {
-            flog::info("REJECTED Connection from {0}:{1}, another client is already connected.", "TODO", "TODO");
-            
-            // Issue a disconnect command to the client
-            uint8_t buf[sizeof(PacketHeader) + sizeof(CommandHeader)];
-            PacketHeader* tmp_phdr = (PacketHeader*)buf;
-            CommandHeader* tmp_chdr = (CommandHeader*)&buf[sizeof(PacketHeader)];
-            tmp_phdr->size = sizeof(PacketHeader) + sizeof(CommandHeader);
-            tmp_phdr->type = PACKET_TYPE_COMMAND;
-            tmp_chdr->cmd = COMMAND_DISCONNECT;
-            conn->write(tmp_phdr->size, buf);
-
-            // TODO: Find something cleaner
+        auto lastStats = std::chrono::steady_clock::now();
+        while(1) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            closeDeadSessions();
 
-            conn->close();
-            
-            // Start another async accept
-            listener->acceptAsync(_clientHandler, NULL);
-            return;
+            // Report how well each client is being served once in a while
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastStats >= std::chrono::seconds(SERVER_STATS_INTERVAL)) {
+                logSessionStats();
+                lastStats = now;
+            }
         }
 
-        flog::info("Connection from {0}:{1}", "TODO", "TODO");
-        client = std::move(conn);
-        client->readAsync(sizeof(PacketHeader), rbuf, _packetHandler, NULL);
-
-        // Perform settings reset
-        sigpath::sourceManager.stop();
-        comp.setPCMType(dsp::compression::PCM_TYPE_I16);
-        compression = false;
+        return 0;
+    }
 
-        sendSampleRate(sampleRate);
+    void _clientHandler(net::Conn conn, void* ctx) {
+        std::lock_guard<std::recursive_mutex> lck(sessionsMtx);
+        Session* session = new Session(nextSessionId++, std::move(conn));
+        sessions.push_back(session);
+        flog::info("Connection from client {0}, {1} client(s) connected", session->id, sessions.size());
+        session->conn->readAsync(sizeof(PacketHeader), session->rbuf, _packetHandler, session);
 
-        // TODO: Wait otherwise someone else could connect
+        sendSampleRate(session, getSessionSampleRate(session));
 
         listener->acceptAsync(_clientHandler, NULL);
     }
 
     void _packetHandler(int count, uint8_t* buf, void* ctx) {
+        Session* session = (Session*)ctx;
         PacketHeader* hdr = (PacketHeader*)buf;
 
         // Read the rest of the data (TODO: CHECK SIZE OR SHIT WILL BE FUCKED + ADD TIMEOUT)
@@ -208,47 +219,241 @@ namespace server {
         int read = 0;
         int goal = hdr->size - sizeof(PacketHeader);
         while (len < goal) {
-            read = client->read(goal - len, &buf[sizeof(PacketHeader) + len]);
+            read = session->conn->read(goal - len, &buf[sizeof(PacketHeader) + len]);
             if (read < 0) { return; };
             len += read;
         }
 
         // Parse and process
-        if (hdr->type == PACKET_TYPE_COMMAND && hdr->size >= sizeof(PacketHeader) + sizeof(CommandHeader)) {
-            CommandHeader* chdr = (CommandHeader*)&buf[sizeof(PacketHeader)];
-            commandHandler((Command)chdr->cmd, &buf[sizeof(PacketHeader) + sizeof(CommandHeader)], hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
-        }
-        else {
-            sendError(ERROR_INVALID_PACKET);
+        {
+            std::lock_guard<std::recursive_mutex> lck(sessionsMtx);
+            if (session->closed) { return; }
+            if (hdr->type == PACKET_TYPE_COMMAND && hdr->size >= sizeof(PacketHeader) + sizeof(CommandHeader)) {
+                CommandHeader* chdr = (CommandHeader*)&buf[sizeof(PacketHeader)];
+                commandHandler(session, (Command)chdr->cmd, &buf[sizeof(PacketHeader) + sizeof(CommandHeader)], hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
+            }
+            else {
+                sendError(session, ERROR_INVALID_PACKET);
+            }
         }
 
         // Start another async read
-        client->readAsync(sizeof(PacketHeader), rbuf, _packetHandler, NULL);
+        session->conn->readAsync(sizeof(PacketHeader), session->rbuf, _packetHandler, session);
     }
 
     void _testServerHandler(uint8_t* data, int count, void* ctx) {
-        // Compress data if needed and fill out header fields
-        if (compression) {
-            bb_pkt_hdr->type = PACKET_TYPE_BASEBAND_COMPRESSED;
-            bb_pkt_hdr->size = sizeof(PacketHeader) + (uint32_t)ZSTD_compressCCtx(cctx, &bbuf[sizeof(PacketHeader)], SERVER_MAX_PACKET_SIZE-sizeof(PacketHeader), data, count, 1);
+        Session* session = (Session*)ctx;
+
+        // Get a free block, drop the data if the sender is too far behind
+        SendBlock* block;
+        {
+            std::lock_guard<std::mutex> lck(session->queueMtx);
+            if (session->freeBlocks.empty()) {
+                session->droppedBlocks++;
+                return;
+            }
+            block = session->freeBlocks.back();
+            session->freeBlocks.pop_back();
         }
-        else {
-            bb_pkt_hdr->type = PACKET_TYPE_BASEBAND;
-            bb_pkt_hdr->size = sizeof(PacketHeader) + count;
-            memcpy(&bbuf[sizeof(PacketHeader)], data, count);
+
+        // Queue the data for the sender
+        memcpy(block->data, data, count);
+        block->size = count;
+        {
+            std::lock_guard<std::mutex> lck(session->queueMtx);
+            session->pendingBlocks.push_back(block);
         }
+        session->queueCnd.notify_one();
+    }
 
-        // Write to network
-        if (client && client->isOpen()) { client->write(bb_pkt_hdr->size, bbuf); }
+    void _sendWorker(Session* session) {
+        PacketHeader* hdr = session->bb_pkt_hdr;
+        int level = SERVER_DEFAULT_COMPRESSION_LEVEL;
+
+        while (true) {
+            // Wait for a block
+            SendBlock* block;
+            {
+                std::unique_lock<std::mutex> lck(session->queueMtx);
+                session->queueCnd.wait(lck, [=]() { return !session->pendingBlocks.empty() || session->stopSender; });
+                if (session->stopSender) { return; }
+                block = session->pendingBlocks.front();
+                session->pendingBlocks.pop_front();
+            }
+
+            // Compress data if needed and fill out header fields
+            if (session->compression) {
+                // The context can only be changed from this thread
+                int newLevel = session->compressionLevel;
+                if (newLevel != level) {
+                    ZSTD_CCtx_setParameter(session->cctx, ZSTD_c_compressionLevel, newLevel);
+                    level = newLevel;
+                }
+                size_t size = ZSTD_compress2(session->cctx, session->bb_pkt_data, SERVER_MAX_PACKET_SIZE-sizeof(PacketHeader), block->data, block->size);
+                if (ZSTD_isError(size)) { size = 0; }
+                hdr->type = PACKET_TYPE_BASEBAND_COMPRESSED;
+                hdr->size = sizeof(PacketHeader) + (uint32_t)size;
+            }
+            else {
+                hdr->type = PACKET_TYPE_BASEBAND;
+                hdr->size = sizeof(PacketHeader) + block->size;
+                memcpy(session->bb_pkt_data, block->data, block->size);
+            }
+            session->rawBytes += block->size;
+
+            // Give the block back before waiting on the network
+            {
+                std::lock_guard<std::mutex> lck(session->queueMtx);
+                session->freeBlocks.push_back(block);
+            }
+
+            // Write to network
+            if (session->conn->isOpen() && session->conn->write(hdr->size, session->bbuf)) {
+                session->sentBytes += hdr->size;
+            }
+        }
     }
 
     void setInput(dsp::stream<dsp::complex_t>* stream) {
-        comp.setInput(stream);
+        splitter.setInput(stream);
     }
 
-    void commandHandler(Command cmd, uint8_t* data, int len) {
+    void startSession(Session* session) {
+        std::lock_guard<std::recursive_mutex> lck(sessionsMtx);
+        if (session->running) { return; }
+        startSessionDSP(session);
+        session->running = true;
+
+        // The source runs as long as at least one client wants samples
+        if (!runningSessions++) {
+            sigpath::sourceManager.start();
+            running = true;
+        }
+    }
+
+    void stopSession(Session* session) {
+        std::lock_guard<std::recursive_mutex> lck(sessionsMtx);
+        if (!session->running) { return; }
+        stopSessionDSP(session);
+        session->running = false;
+
+        if (!--runningSessions) {
+            sigpath::sourceManager.stop();
+            running = false;
+        }
+    }
+
+    void startSessionDSP(Session* session) {
+        if (session->channelSamplerate > 0.0) {
+            session->comp.setInput(&session->ddc.out);
+            session->ddc.start();
+        }
+        else {
+            session->comp.setInput(&session->input);
+        }
+        session->comp.start();
+        session->hnd.start();
+        splitter.bindStream(&session->input);
+    }
+
+    void stopSessionDSP(Session* session) {
+        splitter.unbindStream(&session->input);
+        session->ddc.stop();
+        session->comp.stop();
+        session->hnd.stop();
+    }
+
+    void setChannel(Session* session, double freq, double samplerate, double bandwidth) {
+        std::lock_guard<std::recursive_mutex> lck(sessionsMtx);
+
+        // A channel at least as wide as the baseband is just the baseband
+        if (samplerate >= sampleRate) { samplerate = 0.0; }
+        bandwidth = std::clamp<double>(bandwidth, 0.0, samplerate);
+
+        // Only switching between channel and full baseband changes the DSP path. Rebinding to the splitter
+        // stalls every other client so it must not happen when simply tuning the channel.
+        bool modeChanged = ((samplerate > 0.0) != (session->channelSamplerate > 0.0));
+        bool rateChanged = (samplerate != session->channelSamplerate);
+        bool bandwidthChanged = (bandwidth != session->channelBandwidth);
+        bool wasRunning = session->running;
+        if (modeChanged && wasRunning) { stopSessionDSP(session); }
+        session->channelFreq = freq;
+        session->channelSamplerate = samplerate;
+        session->channelBandwidth = bandwidth;
+        if (samplerate > 0.0) {
+            if (rateChanged || bandwidthChanged) {
+                session->ddc.setInSamplerate(sampleRate);
+                session->ddc.setOutSamplerate(samplerate, bandwidth > 0.0 ? bandwidth : samplerate);
+            }
+            session->ddc.setOffset(freq - frequency);
+        }
+        if (modeChanged && wasRunning) { startSessionDSP(session); }
+
+        // Retune if the channel doesn't fit in the baseband anymore
+        if (samplerate > 0.0 && fabs(freq - frequency) + (samplerate / 2.0) > (sampleRate / 2.0)) {
+            retune(freq);
+        }
+
+        // The client resets its view on every samplerate change, so only send it when it changed
+        if (rateChanged) { sendSampleRate(session, getSessionSampleRate(session)); }
+    }
+
+    void retune(double freq) {
+        std::lock_guard<std::recursive_mutex> lck(sessionsMtx);
+        sigpath::sourceManager.tune(freq);
+        frequency = freq;
+
+        // Channels stay on the same frequency, so their offset in the baseband changes
+        for (auto& session : sessions) {
+            if (session->channelSamplerate <= 0.0) { continue; }
+            session->ddc.setOffset(session->channelFreq - frequency);
+        }
+    }
+
+    void closeDeadSessions() {
+        // Take the sessions out of the list with the lock held but close them without,
+        // the read thread of their connection may be waiting for it.
+        std::vector<Session*> dead;
+        {
+            std::lock_guard<std::recursive_mutex> lck(sessionsMtx);
+            for (auto it = sessions.begin(); it != sessions.end();) {
+                Session* session = *it;
+                if (session->conn->isOpen()) {
+                    it++;
+                    continue;
+                }
+                stopSession(session);
+                session->closed = true;
+                dead.push_back(session);
+                it = sessions.erase(it);
+                flog::info("Client {0} disconnected, {1} client(s) connected", session->id, sessions.size());
+            }
+        }
+        for (auto& session : dead) { delete session; }
+    }
+
+    void logSessionStats() {
+        std::lock_guard<std::recursive_mutex> lck(sessionsMtx);
+        for (auto& session : sessions) {
+            if (!session->running) { continue; }
+            uint64_t raw = session->rawBytes.exchange(0);
+            uint64_t sent = session->sentBytes.exchange(0);
+            uint64_t dropped = session->droppedBlocks.exchange(0);
+            double ratio = sent ? (double)raw / (double)sent : 0.0;
+            double rate = (double)sent * 8.0 / (SERVER_STATS_INTERVAL * 1000000.0);
+            char buf[128];
+            sprintf(buf, "%.3f Mbit/s, compression ratio %.2f", rate, ratio);
+            flog::info("Client {0}: {1}, {2} dropped blocks", session->id, buf, dropped);
+        }
+    }
+
+    double getSessionSampleRate(Session* session) {
+        return (session->channelSamplerate > 0.0) ? session->channelSamplerate : sampleRate;
+    }
+
+    void commandHandler(Session* session, Command cmd, uint8_t* data, int len) {
         if (cmd == COMMAND_GET_UI) {
-            sendUI(COMMAND_GET_UI, "", dummyElem);
+            sendUI(session, COMMAND_GET_UI, "", dummyElem);
         }
         else if (cmd == COMMAND_UI_ACTION && len >= 3) {
             // Check if sending back data is needed
@@ -259,48 +464,53 @@ namespace server {
             // Load id
             SmGui::DrawListElem diffId;
             int count = SmGui::DrawList::loadItem(diffId, &data[i], len);
-            if (count < 0) { sendError(ERROR_INVALID_ARGUMENT); return; }
-            if (diffId.type != SmGui::DRAW_LIST_ELEM_TYPE_STRING) { sendError(ERROR_INVALID_ARGUMENT); return; } 
+            if (count < 0) { sendError(session, ERROR_INVALID_ARGUMENT); return; }
+            if (diffId.type != SmGui::DRAW_LIST_ELEM_TYPE_STRING) { sendError(session, ERROR_INVALID_ARGUMENT); return; } 
             i += count;
             len -= count;
 
             // Load value
             SmGui::DrawListElem diffValue;
             count = SmGui::DrawList::loadItem(diffValue, &data[i], len);
-            if (count < 0) { sendError(ERROR_INVALID_ARGUMENT); return; }
+            if (count < 0) { sendError(session, ERROR_INVALID_ARGUMENT); return; }
             i += count;
             len -= count;
 
             // Render and send back
             if (sendback) {
-                sendUI(COMMAND_UI_ACTION, diffId.str, diffValue);
+                sendUI(session, COMMAND_UI_ACTION, diffId.str, diffValue);
             }
             else {
                 renderUI(NULL, diffId.str, diffValue);
             }
         }
         else if (cmd == COMMAND_START) {
-            sigpath::sourceManager.start();
-            running = true;
+            startSession(session);
         }
         else if (cmd == COMMAND_STOP) {
-            sigpath::sourceManager.stop();
-            running = false;
+            stopSession(session);
         }
         else if (cmd == COMMAND_SET_FREQUENCY && len == 8) {
-            sigpath::sourceManager.tune(*(double*)data);
-            sendCommandAck(COMMAND_SET_FREQUENCY, 0);
+            retune(*(double*)data);
+            std::lock_guard<std::mutex> lck(session->sendMtx);
+            sendCommandAck(session, COMMAND_SET_FREQUENCY, 0);
         }
         else if (cmd == COMMAND_SET_SAMPLE_TYPE && len == 1) {
             dsp::compression::PCMType type = (dsp::compression::PCMType)*(uint8_t*)data;
-            comp.setPCMType(type);
+            session->comp.setPCMType(type);
+        }
+        else if (cmd == COMMAND_SET_COMPRESSION && (len == 1 || len == 2)) {
+            // The level is left out by older clients and when it is the default one
+            session->compression = data[0];
+            session->compressionLevel = (len == 2) ? std::clamp<int>((int8_t)data[1], 1, ZSTD_maxCLevel()) : SERVER_DEFAULT_COMPRESSION_LEVEL;
         }
-        else if (cmd == COMMAND_SET_COMPRESSION && len == 1) {
-            compression = *(uint8_t*)data;
+        else if (cmd == COMMAND_SET_CHANNEL && len == sizeof(ChannelRequest)) {
+            ChannelRequest* req = (ChannelRequest*)data;
+            setChannel(session, req->frequency, req->samplerate, req->bandwidth);
         }
         else {
             flog::error("Invalid Command: {0} (len = {1})", (int)cmd, len);
-            sendError(ERROR_INVALID_COMMAND);
+            sendError(session, ERROR_INVALID_COMMAND);
         }
     }
 
@@ -339,49 +549,64 @@ namespace server {
         }
     }
 
-    void sendUI(Command originCmd, std::string diffId, SmGui::DrawListElem diffValue) {
+    void sendUI(Session* session, Command originCmd, std::string diffId, SmGui::DrawListElem diffValue) {
+        std::lock_guard<std::mutex> lck(session->sendMtx);
+
         // Render UI
         SmGui::DrawList dl;
         renderUI(&dl, diffId, diffValue);
 
         // Create response
         int size = dl.getSize();
-        dl.store(s_cmd_data, size);
+        dl.store(session->s_cmd_data, size);
 
         // Send to network
-        sendCommandAck(originCmd, size);
+        sendCommandAck(session, originCmd, size);
     }
 
-    void sendError(Error err) {
-        PacketHeader* hdr = (PacketHeader*)sbuf;
-        s_pkt_data[0] = err;
-        sendPacket(PACKET_TYPE_ERROR, 1);
+    void sendError(Session* session, Error err) {
+        std::lock_guard<std::mutex> lck(session->sendMtx);
+        session->s_pkt_data[0] = err;
+        sendPacket(session, PACKET_TYPE_ERROR, 1);
     }
 
-    void sendSampleRate(double sampleRate) {
-        *(double*)s_cmd_data = sampleRate;
-        sendCommand(COMMAND_SET_SAMPLERATE, sizeof(double));
+    void sendSampleRate(Session* session, double sampleRate) {
+        std::lock_guard<std::mutex> lck(session->sendMtx);
+        *(double*)session->s_cmd_data = sampleRate;
+        sendCommand(session, COMMAND_SET_SAMPLERATE, sizeof(double));
     }
 
     void setInputSampleRate(double samplerate) {
+        std::lock_guard<std::recursive_mutex> lck(sessionsMtx);
         sampleRate = samplerate;
-        if (!client || !client->isOpen()) { return; }
-        sendSampleRate(sampleRate);
+
+        // Clients receiving the full baseband see the new samplerate, the others keep their channel
+        for (auto& session : sessions) {
+            if (session->channelSamplerate > 0.0) {
+                if (session->channelSamplerate < sampleRate) {
+                    session->ddc.setInSamplerate(sampleRate);
+                    continue;
+                }
+                setChannel(session, session->channelFreq, 0.0, 0.0);
+                continue;
+            }
+            sendSampleRate(session, sampleRate);
+        }
     }
 
-    void sendPacket(PacketType type, int len) {
-        s_pkt_hdr->type = type;
-        s_pkt_hdr->size = sizeof(PacketHeader) + len;
-        client->write(s_pkt_hdr->size, sbuf);
+    void sendPacket(Session* session, PacketType type, int len) {
+        session->s_pkt_hdr->type = type;
+        session->s_pkt_hdr->size = sizeof(PacketHeader) + len;
+        session->conn->write(session->s_pkt_hdr->size, session->sbuf);
     }
 
-    void sendCommand(Command cmd, int len) {
-        s_cmd_hdr->cmd = cmd;
-        sendPacket(PACKET_TYPE_COMMAND, sizeof(CommandHeader) + len);
+    void sendCommand(Session* session, Command cmd, int len) {
+        session->s_cmd_hdr->cmd = cmd;
+        sendPacket(session, PACKET_TYPE_COMMAND, sizeof(CommandHeader) + len);
     }
 
-    void sendCommandAck(Command cmd, int len) {
-        s_cmd_hdr->cmd = cmd;
-        sendPacket(PACKET_TYPE_COMMAND_ACK, sizeof(CommandHeader) + len);
+    void sendCommandAck(Session* session, Command cmd, int len) {
+        session->s_cmd_hdr->cmd = cmd;
+        sendPacket(session, PACKET_TYPE_COMMAND_ACK, sizeof(CommandHeader) + len);
     }
-}
+}
\ No newline at end of file
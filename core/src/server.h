@@ -2,26 +2,111 @@
 #include <utils/networking.h>
 #include <dsp/stream.h>
 #include <dsp/types.h>
+#include <dsp/channel/rx_vfo.h>
+#include <dsp/compression/sample_stream_compressor.h>
+#include <dsp/sink/handler_sink.h>
 #include <server_protocol.h>
+#include <zstd.h>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <condition_variable>
+
+// Number of blocks that can wait to be compressed and sent before new ones get dropped
+#define SERVER_SEND_QUEUE_SIZE      4
+
+// Number of threads used by zstd to compress each block
+#define SERVER_COMPRESSION_WORKERS  2
+
+// Time between two reports of the per-client statistics, in seconds
+#define SERVER_STATS_INTERVAL       10
 
 namespace server {
+    struct SendBlock {
+        uint8_t* data;
+        int size;
+    };
+
+    // State of a connected client. Each client gets its own copy of the baseband, optionally
+    // brought down to a narrower channel by a DDC, with its own sample type and compression.
+    struct Session {
+        Session(int id, net::Conn conn);
+        ~Session();
+
+        int id;
+        net::Conn conn;
+        bool closed = false;
+        std::mutex sendMtx;
+
+        uint8_t* rbuf = NULL;
+        uint8_t* sbuf = NULL;
+        uint8_t* bbuf = NULL;
+
+        PacketHeader* s_pkt_hdr = NULL;
+        uint8_t* s_pkt_data = NULL;
+        CommandHeader* s_cmd_hdr = NULL;
+        uint8_t* s_cmd_data = NULL;
+
+        PacketHeader* bb_pkt_hdr = NULL;
+        uint8_t* bb_pkt_data = NULL;
+
+        dsp::stream<dsp::complex_t> input;
+        dsp::channel::RxVFO ddc;
+        dsp::compression::SampleStreamCompressor comp;
+        dsp::sink::Handler<uint8_t> hnd;
+        ZSTD_CCtx* cctx;
+
+        // Blocks are compressed and sent by their own thread so that a slow link or compressor never stalls the DSP
+        std::thread sendThread;
+        std::mutex queueMtx;
+        std::condition_variable queueCnd;
+        std::deque<SendBlock*> pendingBlocks;
+        std::vector<SendBlock*> freeBlocks;
+        bool stopSender = false;
+
+        bool running = false;
+        std::atomic<bool> compression = { false };
+        std::atomic<int> compressionLevel = { SERVER_DEFAULT_COMPRESSION_LEVEL };
+
+        std::atomic<uint64_t> rawBytes = { 0 };
+        std::atomic<uint64_t> sentBytes = { 0 };
+        std::atomic<uint64_t> droppedBlocks = { 0 };
+
+        // A channel samplerate of zero means the full baseband is sent
+        double channelFreq = 0.0;
+        double channelSamplerate = 0.0;
+        double channelBandwidth = 0.0;
+    };
+
     void setInput(dsp::stream<dsp::complex_t>* stream);
     int main();
 
     void _clientHandler(net::Conn conn, void* ctx);
     void _packetHandler(int count, uint8_t* buf, void* ctx);
     void _testServerHandler(uint8_t* data, int count, void* ctx);
+    void _sendWorker(Session* session);
 
     void drawMenu();
 
-    void commandHandler(Command cmd, uint8_t* data, int len);
+    void startSession(Session* session);
+    void stopSession(Session* session);
+    void startSessionDSP(Session* session);
+    void stopSessionDSP(Session* session);
+    void setChannel(Session* session, double freq, double samplerate, double bandwidth);
+    void retune(double freq);
+    void closeDeadSessions();
+    void logSessionStats();
+    double getSessionSampleRate(Session* session);
+
+    void commandHandler(Session* session, Command cmd, uint8_t* data, int len);
     void renderUI(SmGui::DrawList* dl, std::string diffId, SmGui::DrawListElem diffValue);
-    void sendUI(Command originCmd, std::string diffId, SmGui::DrawListElem diffValue);
-    void sendError(Error err);
-    void sendSampleRate(double sampleRate);
+    void sendUI(Session* session, Command originCmd, std::string diffId, SmGui::DrawListElem diffValue);
+    void sendError(Session* session, Error err);
+    void sendSampleRate(Session* session, double sampleRate);
     void setInputSampleRate(double samplerate);
 
-    void sendPacket(PacketType type, int len);
-    void sendCommand(Command cmd, int len);
-    void sendCommandAck(Command cmd, int len);
+    void sendPacket(Session* session, PacketType type, int len);
+    void sendCommand(Session* session, Command cmd, int len);
+    void sendCommandAck(Session* session, Command cmd, int len);
 }
@@ -5,6 +5,9 @@
 
 #define SERVER_MAX_PACKET_SIZE  (STREAM_BUFFER_SIZE * sizeof(dsp::complex_t) * 2)
 
+// Compression level used when the client doesn't send one, servers older than the level only accept that form
+#define SERVER_DEFAULT_COMPRESSION_LEVEL    1
+
 namespace server {
     enum PacketType {
         // Client to Server
@@ -27,6 +30,7 @@ namespace server {
         COMMAND_GET_SAMPLERATE,
         COMMAND_SET_SAMPLE_TYPE,
         COMMAND_SET_COMPRESSION,
+        COMMAND_SET_CHANNEL,
 
         // Server to client
         COMMAND_SET_SAMPLERATE = 0x80,
@@ -49,5 +53,12 @@ namespace server {
     struct CommandHeader {
         uint32_t cmd;
     };
+
+    // Argument of COMMAND_SET_CHANNEL, a samplerate of zero selects the full baseband
+    struct ChannelRequest {
+        double frequency;
+        double samplerate;
+        double bandwidth;
+    };
 #pragma pack(pop)
 }
\ No newline at end of file
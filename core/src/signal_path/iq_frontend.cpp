@@ -2,6 +2,8 @@
 #include "../dsp/window/blackman.h"
 #include "../dsp/window/nuttall.h"
 #include <utils/flog.h>
+#include <utils/trace.h>
+#include <utils/fft_plan.h>
 #include <gui/gui.h>
 #include <core.h>
 
@@ -9,7 +11,7 @@ IQFrontEnd::~IQFrontEnd() {
     if (!_init) { return; }
     stop();
     dsp::buffer::free(fftWindowBuf);
-    fftwf_destroy_plan(fftwPlan);
+    fftplan::destroy(fftwPlan);
     fftwf_free(fftInBuf);
     fftwf_free(fftOutBuf);
 }
@@ -39,6 +41,10 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
     preproc.addBlock(&conjugate, false); // TODO: Replace by parameter
 
     split.init(preproc.out);
+    split.setShared(true); // Every consumer reads the same buffer instead of its own copy
+
+    // The channelizer is only bound to the splitter when enabled
+    chan.init(&chanIn, effectiveSr);
 
     // TODO: Do something to avoid basically repeating this code twice
     int skip;
@@ -46,25 +52,36 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
     reshape.init(&fftIn, fftSize, skip);
     fftSink.init(&reshape.out, handler, this);
 
-    fftWindowBuf = dsp::buffer::alloc<float>(_nzFFTSize);
-    if (_fftWindow == FFTWindow::RECTANGULAR) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = 0; }
-    }
-    else if (_fftWindow == FFTWindow::BLACKMAN) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::blackman(i, _nzFFTSize); }
+    // Names shown by the DSP profiler
+    inBuf.setName("IQ Front End Buffer");
+    split.setName("IQ Front End Splitter");
+    chan.setName("IQ Front End Channelizer");
+    reshape.setName("FFT Reshaper");
+    fftSink.setName("FFT Sink");
+
+    // The FFT is only allocated and bound to the splitter when enabled
+    if (_fftEnabled) {
+        fftWindowBuf = dsp::buffer::alloc<float>(_nzFFTSize);
+        if (_fftWindow == FFTWindow::RECTANGULAR) {
+            for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = 0; }
+        }
+        else if (_fftWindow == FFTWindow::BLACKMAN) {
+            for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::blackman(i, _nzFFTSize); }
+        }
+        else if (_fftWindow == FFTWindow::NUTTALL) {
+            for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::nuttall(i, _nzFFTSize); }
+        }
+
+        fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
+        fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
+        fftplan::wisdomChanged(fftWisdomGen);
+        fftwPlan = fftplan::create(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD);
+
+        // Clear the rest of the FFT input buffer
+        dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
+
+        split.bindStream(&fftIn);
     }
-    else if (_fftWindow == FFTWindow::NUTTALL) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::nuttall(i, _nzFFTSize); }
-    }
-
-    fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
-
-    // Clear the rest of the FFT input buffer
-    dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
-
-    split.bindStream(&fftIn);
 
     _init = true;
 }
@@ -84,8 +101,14 @@ void IQFrontEnd::setSampleRate(double sampleRate) {
     _sampleRate = sampleRate;
     effectiveSr = _sampleRate / _decimRatio;
     dcBlock.setRate(genDCBlockRate(effectiveSr));
+    chan.setSamplerate(effectiveSr);
     for (auto& [name, vfo] : vfos) {
-        vfo->setInSamplerate(effectiveSr);
+        if (_channelizer) {
+            updateVFOChannel(name);
+        }
+        else {
+            vfo->setInSamplerate(effectiveSr);
+        }
     }
 
     // Reconfigure the FFT
@@ -146,12 +169,24 @@ dsp::channel::RxVFO* IQFrontEnd::addVFO(std::string name, double sampleRate, dou
 
     // Create VFO and its input stream
     dsp::stream<dsp::complex_t>* vfoIn = new dsp::stream<dsp::complex_t>;
+    vfoIn->setDepth(3); // Absorb jitter so one slow VFO doesn't immediately stall the splitter
     dsp::channel::RxVFO* vfo = new dsp::channel::RxVFO(vfoIn, effectiveSr, sampleRate, bandwidth, offset);
+    if (_scheduler) { vfo->setScheduler(_scheduler); }
+    vfo->setName("VFO " + name);
 
     // Register them
     vfoStreams[name] = vfoIn;
     vfos[name] = vfo;
-    bindIQStream(vfoIn);
+    vfoOffsets[name] = offset;
+    vfoSamplerates[name] = sampleRate;
+
+    // Feed it either from the channelizer or directly from the splitter
+    if (_channelizer) {
+        bindVFOChannel(name);
+    }
+    else {
+        bindIQStream(vfoIn);
+    }
 
     // Start VFO
     vfo->start();
@@ -173,15 +208,121 @@ void IQFrontEnd::removeVFO(std::string name) {
     // Stop the VFO
     vfo->stop();
 
-    unbindIQStream(vfoIn);
+    if (_channelizer) {
+        unbindVFOChannel(name);
+    }
+    else {
+        unbindIQStream(vfoIn);
+    }
     vfoStreams.erase(name);
     vfos.erase(name);
+    vfoOffsets.erase(name);
+    vfoSamplerates.erase(name);
 
     // Delete the VFO and its input stream
     delete vfo;
     delete vfoIn;
 }
 
+void IQFrontEnd::setVFOOffset(std::string name, double offset) {
+    // Make sure that a VFO with that name exists
+    if (vfos.find(name) == vfos.end()) {
+        flog::error("[IQFrontEnd] Tried to set the offset of a VFO that doesn't exist.");
+        return;
+    }
+
+    // When channelized, the channelizer does the coarse tuning and the VFO only corrects the residual
+    vfoOffsets[name] = offset;
+    if (_channelizer) {
+        dsp::channel::Channelizer::Channel* ch = vfoChannels[name];
+        chan.setOffset(ch, offset);
+        vfos[name]->setOffset(chan.getResidualOffset(ch));
+    }
+    else {
+        vfos[name]->setOffset(offset);
+    }
+}
+
+void IQFrontEnd::setVFOSamplerate(std::string name, double sampleRate, double bandwidth) {
+    // Make sure that a VFO with that name exists
+    if (vfos.find(name) == vfos.end()) {
+        flog::error("[IQFrontEnd] Tried to set the samplerate of a VFO that doesn't exist.");
+        return;
+    }
+
+    // Update the VFO, the channel decimation may have to change with it
+    vfoSamplerates[name] = sampleRate;
+    vfos[name]->setOutSamplerate(sampleRate, bandwidth);
+    if (_channelizer) { updateVFOChannel(name); }
+}
+
+void IQFrontEnd::setChannelizer(bool enabled) {
+    if (_channelizer == enabled) { return; }
+
+    if (enabled) {
+        // Start the channelizer and move every VFO onto its own channel
+        bindIQStream(&chanIn);
+        if (_running) { chan.start(); }
+        for (auto& [name, vfo] : vfos) {
+            unbindIQStream(vfoStreams[name]);
+            bindVFOChannel(name);
+        }
+    }
+    else {
+        // Move every VFO back to a full rate copy of the IQ and stop the channelizer
+        for (auto& [name, vfo] : vfos) {
+            vfo->tempStop();
+            vfo->setInput(vfoStreams[name]);
+            unbindVFOChannel(name);
+            vfo->setInSamplerate(effectiveSr);
+            vfo->setOffset(vfoOffsets[name]);
+            bindIQStream(vfoStreams[name]);
+            vfo->tempStart();
+        }
+        chan.stop();
+        unbindIQStream(&chanIn);
+    }
+
+    _channelizer = enabled;
+}
+
+void IQFrontEnd::setScheduler(dsp::Scheduler* scheduler) {
+    if (_scheduler == scheduler) { return; }
+
+    // Move the splitter, channelizer and all VFOs to the scheduler or back to their own threads
+    split.setScheduler(scheduler);
+    chan.setScheduler(scheduler);
+    for (auto& [name, vfo] : vfos) {
+        vfo->setScheduler(scheduler);
+    }
+
+    _scheduler = scheduler;
+}
+
+void IQFrontEnd::setFFTEnabled(bool enabled) {
+    if (_fftEnabled == enabled) { return; }
+    _fftEnabled = enabled;
+
+    // Before init, only init needs to know
+    if (!_init) { return; }
+
+    if (enabled) {
+        // Rebuild the FFT with the current settings and feed it
+        updateFFTPath(true);
+        if (_running) {
+            reshape.start();
+            fftSink.start();
+        }
+        split.bindStream(&fftIn);
+    }
+    else {
+        // Stop feeding the FFT before stopping it so that the splitter never waits on it
+        split.unbindStream(&fftIn);
+        reshape.stop();
+        fftSink.stop();
+    }
+}
+
 void IQFrontEnd::setFFTSize(int size) {
     _fftSize = size;
     updateFFTPath(true);
@@ -211,14 +352,21 @@ void IQFrontEnd::start() {
     // Start IQ splitter
     split.start();
 
+    // Start the channelizer if used
+    if (_channelizer) { chan.start(); }
+
     // Start all VFOs
     for (auto& [name, vfo] : vfos) {
         vfo->start();
     }
 
-    // Start FFT chain
-    reshape.start();
-    fftSink.start();
+    // Start FFT chain if used
+    if (_fftEnabled) {
+        reshape.start();
+        fftSink.start();
+    }
+
+    _running = true;
 }
 
 void IQFrontEnd::stop() {
@@ -231,6 +379,9 @@ void IQFrontEnd::stop() {
     // Stop IQ splitter
     split.stop();
 
+    // Stop the channelizer
+    chan.stop();
+
     // Stop all VFOs
     for (auto& [name, vfo] : vfos) {
         vfo->stop();
@@ -239,6 +390,8 @@ void IQFrontEnd::stop() {
     // Stop FFT chain
     reshape.stop();
     fftSink.stop();
+
+    _running = false;
 }
 
 double IQFrontEnd::getEffectiveSamplerate() {
@@ -246,8 +399,18 @@ double IQFrontEnd::getEffectiveSamplerate() {
 }
 
 void IQFrontEnd::handler(dsp::complex_t* data, int count, void* ctx) {
+    TRACE_SCOPE("IQFrontEnd::handler");
     IQFrontEnd* _this = (IQFrontEnd*)ctx;
 
+    // Switch to a faster plan once the background planner measured one, without waiting on it
+    uint64_t gen = _this->fftWisdomGen;
+    if (fftplan::wisdomChanged(gen) && fftplan::upgrade(_this->fftwPlan, _this->_fftSize, _this->fftInBuf, _this->fftOutBuf, FFTW_FORWARD)) {
+        _this->fftWisdomGen = gen;
+
+        // Planning may have overwritten the zero padding
+        dsp::buffer::clear(_this->fftInBuf, _this->_fftSize - _this->_nzFFTSize, _this->_nzFFTSize);
+    }
+
     // Apply window
     volk_32fc_32f_multiply_32fc((lv_32fc_t*)_this->fftInBuf, (lv_32fc_t*)data, _this->fftWindowBuf, _this->_nzFFTSize);
 
@@ -266,7 +429,43 @@ void IQFrontEnd::handler(dsp::complex_t* data, int count, void* ctx) {
     _this->_releaseFFTBuffer(_this->_fftCtx);
 }
 
+void IQFrontEnd::bindVFOChannel(std::string name) {
+    dsp::channel::RxVFO* vfo = vfos[name];
+    vfo->tempStop();
+
+    // Create a channel decimated as much as the VFO's output samplerate allows
+    double offset = vfoOffsets[name];
+    dsp::channel::Channelizer::Channel* ch = chan.addChannel(offset, chan.getDecimation(vfoSamplerates[name]));
+    vfoChannels[name] = ch;
+
+    // Run the VFO at the channel samplerate
+    vfo->setInput(&ch->out);
+    vfo->setInSamplerate(chan.getChannelSamplerate(ch));
+    vfo->setOffset(chan.getResidualOffset(ch));
+
+    vfo->tempStart();
+}
+
+void IQFrontEnd::unbindVFOChannel(std::string name) {
+    chan.removeChannel(vfoChannels[name]);
+    vfoChannels.erase(name);
+}
+
+void IQFrontEnd::updateVFOChannel(std::string name) {
+    dsp::channel::RxVFO* vfo = vfos[name];
+    dsp::channel::Channelizer::Channel* ch = vfoChannels[name];
+    vfo->tempStop();
+    chan.setDecimation(ch, chan.getDecimation(vfoSamplerates[name]));
+    chan.setOffset(ch, vfoOffsets[name]);
+    vfo->setInSamplerate(chan.getChannelSamplerate(ch));
+    vfo->setOffset(chan.getResidualOffset(ch));
+    vfo->tempStart();
+}
+
 void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
+    // Settings are applied when the FFT gets enabled
+    if (!_fftEnabled) { return; }
+
     // Temp stop branch
     reshape.tempStop();
     fftSink.tempStop();
@@ -290,12 +489,14 @@ void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
         for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::nuttall(i, _nzFFTSize) * ((i % 2) ? -1.0f : 1.0f); }
     }
 
-    // Update FFT plan
+    // Update FFT plan, the old one must be destroyed before its buffers
+    fftplan::destroy(fftwPlan);
     fftwf_free(fftInBuf);
     fftwf_free(fftOutBuf);
     fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
     fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
+    fftplan::wisdomChanged(fftWisdomGen);
+    fftwPlan = fftplan::create(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD);
 
     // Clear the rest of the FFT input buffer
     dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
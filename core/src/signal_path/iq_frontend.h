@@ -6,6 +6,7 @@
 #include "../dsp/chain.h"
 #include "../dsp/routing/splitter.h"
 #include "../dsp/channel/rx_vfo.h"
+#include "../dsp/channel/channelizer.h"
 #include "../dsp/sink/handler_sink.h"
 #include "../dsp/math/conjugate.h"
 #include <fftw3.h>
@@ -36,6 +37,18 @@ public:
 
     dsp::channel::RxVFO* addVFO(std::string name, double sampleRate, double bandwidth, double offset);
     void removeVFO(std::string name);
+    void setVFOOffset(std::string name, double offset);
+    void setVFOSamplerate(std::string name, double sampleRate, double bandwidth);
+
+    void setChannelizer(bool enabled);
+    inline bool getChannelizer() { return _channelizer; }
+
+    void setScheduler(dsp::Scheduler* scheduler);
+    inline dsp::Scheduler* getScheduler() { return _scheduler; }
+
+    // When disabled the FFT branch is unbound from the splitter and no FFT is computed, for use without a GUI
+    void setFFTEnabled(bool enabled);
+    inline bool getFFTEnabled() { return _fftEnabled; }
 
     void setFFTSize(int size);
     void setFFTRate(double rate);
@@ -51,6 +64,9 @@ public:
 protected:
     static void handler(dsp::complex_t* data, int count, void* ctx);
     void updateFFTPath(bool updateWaterfall = false);
+    void bindVFOChannel(std::string name);
+    void unbindVFOChannel(std::string name);
+    void updateVFOChannel(std::string name);
 
     static inline double genDCBlockRate(double sampleRate) {
         return 50.0 / sampleRate;
@@ -79,9 +95,16 @@ protected:
     dsp::buffer::Reshaper<dsp::complex_t> reshape;
     dsp::sink::Handler<dsp::complex_t> fftSink;
 
+    // Channelizer
+    dsp::stream<dsp::complex_t> chanIn;
+    dsp::channel::Channelizer chan;
+
     // VFOs
     std::map<std::string, dsp::stream<dsp::complex_t>*> vfoStreams;
     std::map<std::string, dsp::channel::RxVFO*> vfos;
+    std::map<std::string, dsp::channel::Channelizer::Channel*> vfoChannels;
+    std::map<std::string, double> vfoOffsets;
+    std::map<std::string, double> vfoSamplerates;
 
     // Parameters
     double _sampleRate;
@@ -92,12 +115,17 @@ protected:
     float* (*_acquireFFTBuffer)(void* ctx);
     void (*_releaseFFTBuffer)(void* ctx);
     void* _fftCtx;
+    bool _channelizer = false;
+    bool _fftEnabled = true;
+    bool _running = false;
+    dsp::Scheduler* _scheduler = NULL;
 
     // Processing data
     int _nzFFTSize;
-    float* fftWindowBuf;
-    fftwf_complex *fftInBuf, *fftOutBuf;
-    fftwf_plan fftwPlan;
+    float* fftWindowBuf = NULL;
+    fftwf_complex *fftInBuf = NULL, *fftOutBuf = NULL;
+    fftwf_plan fftwPlan = NULL;
+    uint64_t fftWisdomGen = 0;
     float* fftDbOut;
 
     double effectiveSr;
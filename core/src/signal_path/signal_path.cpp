@@ -1,6 +1,8 @@
 #include <signal_path/signal_path.h>
 
 namespace sigpath {
+    // Defined first so it outlives the blocks scheduled on it
+    dsp::Scheduler dspScheduler;
     IQFrontEnd iqFrontEnd;
     VFOManager vfoManager;
     SourceManager sourceManager;
@@ -23,6 +23,7 @@ void SinkManager::Stream::init(dsp::stream<dsp::stereo_t>* in, EventHandler<floa
     srChange.bindHandler(srChangeHandler);
     _sampleRate = sampleRate;
     splitter.init(_in);
+    splitter.setShared(true);
     splitter.bindStream(&volumeInput);
     volumeAjust.init(&volumeInput, 1.0f, false);
     sinkOut = &volumeAjust.out;
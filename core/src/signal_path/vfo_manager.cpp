@@ -29,7 +29,7 @@ VFOManager::VFO::~VFO() {
 
 void VFOManager::VFO::setOffset(double offset) {
     wtfVFO->setOffset(offset);
-    dspVFO->setOffset(wtfVFO->centerOffset);
+    sigpath::iqFrontEnd.setVFOOffset(name, wtfVFO->centerOffset);
 }
 
 double VFOManager::VFO::getOffset() {
@@ -38,7 +38,7 @@ double VFOManager::VFO::getOffset() {
 
 void VFOManager::VFO::setCenterOffset(double offset) {
     wtfVFO->setCenterOffset(offset);
-    dspVFO->setOffset(offset);
+    sigpath::iqFrontEnd.setVFOOffset(name, offset);
 }
 
 void VFOManager::VFO::setBandwidth(double bandwidth, bool updateWaterfall) {
@@ -49,7 +49,7 @@ void VFOManager::VFO::setBandwidth(double bandwidth, bool updateWaterfall) {
 }
 
 void VFOManager::VFO::setSampleRate(double sampleRate, double bandwidth) {
-    dspVFO->setOutSamplerate(sampleRate, bandwidth);
+    sigpath::iqFrontEnd.setVFOSamplerate(name, sampleRate, bandwidth);
     wtfVFO->setBandwidth(bandwidth);
 }
 
@@ -204,7 +204,7 @@ void VFOManager::updateFromWaterfall(ImGui::WaterFall* wtf) {
     for (auto const& [name, vfo] : vfos) {
         if (vfo->wtfVFO->centerOffsetChanged) {
             vfo->wtfVFO->centerOffsetChanged = false;
-            vfo->dspVFO->setOffset(vfo->wtfVFO->centerOffset);
+            sigpath::iqFrontEnd.setVFOOffset(name, vfo->wtfVFO->centerOffset);
         }
     }
 }
\ No newline at end of file
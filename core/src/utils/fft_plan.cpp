@@ -0,0 +1,249 @@
+#include "fft_plan.h"
+#include <utils/flog.h>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <condition_variable>
+
+// FFTs at least this big are planned with multiple threads
+#define FFT_PLAN_THREADED_MIN_SIZE  65536
+
+// Maximum time spent measuring one FFT size, in seconds
+#define FFT_PLAN_MEASURE_TIME_LIMIT 0.5
+
+// Time waited on exit for a measurement to finish before abandoning it, in milliseconds
+#define FFT_PLAN_EXIT_TIMEOUT       200
+
+namespace fftplan {
+    struct Job {
+        int size;
+        int sign;
+    };
+
+    // State of the background planner. It is left allocated if the planner is abandoned on exit
+    // in the middle of a measurement since its thread may still use it.
+    struct Worker {
+        std::thread thread;
+        std::mutex jobMtx;
+        std::condition_variable jobCV;
+        std::condition_variable doneCV;
+        std::deque<Job> jobs;
+        bool stop = false;
+        bool stopped = false;
+        std::atomic<bool> abandoned = { false };
+    };
+
+    std::string _wisdomPath;
+    bool _init = false;
+
+    // Protects the FFTW calls made by fftplan and the thread count of the planner. It is never held during
+    // a single threaded measurement, only the FFTW planner's own lock is.
+    std::mutex plannerMtx;
+
+    Worker* worker = NULL;
+    std::atomic<bool> measuring = { false };
+    std::atomic<uint64_t> wisdomGen = { 0 };
+
+    int threadCount(int size) {
+#ifdef SDRPP_FFTW_THREADS
+        if (size >= FFT_PLAN_THREADED_MIN_SIZE) { return std::clamp<int>(std::thread::hardware_concurrency() / 2, 1, 4); }
+#endif
+        return 1;
+    }
+
+    // The thread count is only ever changed with plannerMtx held and put back to one after planning so
+    // that it never applies to another plan.
+    fftwf_plan planDFT(int size, fftwf_complex* in, fftwf_complex* out, int sign, unsigned int flags) {
+        int threads = threadCount(size);
+#ifdef SDRPP_FFTW_THREADS
+        if (threads > 1) { fftwf_plan_with_nthreads(threads); }
+#endif
+        fftwf_plan plan = fftwf_plan_dft_1d(size, in, out, sign, flags);
+#ifdef SDRPP_FFTW_THREADS
+        if (threads > 1) { fftwf_plan_with_nthreads(1); }
+#endif
+        return plan;
+    }
+
+    void saveWisdom() {
+        // Write to a temporary file first so that an exit in the middle never leaves a truncated file
+        std::string tmpPath = _wisdomPath + ".tmp";
+        if (!fftwf_export_wisdom_to_filename(tmpPath.c_str())) {
+            flog::error("Could not save FFTW wisdom to {0}", _wisdomPath);
+            return;
+        }
+        std::error_code err;
+        std::filesystem::rename(tmpPath, _wisdomPath, err);
+        if (err) { flog::error("Could not save FFTW wisdom to {0}: {1}", _wisdomPath, err.message()); }
+    }
+
+    void measure(const Job& job) {
+        fftwf_complex* in = fftwf_alloc_complex(job.size);
+        fftwf_complex* out = fftwf_alloc_complex(job.size);
+        fftwf_plan plan = planDFT(job.size, in, out, job.sign, FFTW_MEASURE);
+        if (plan) { fftwf_destroy_plan(plan); }
+        fftwf_free(in);
+        fftwf_free(out);
+    }
+
+    void workerLoop(Worker* w) {
+        while (true) {
+            // Wait for a size to measure
+            Job job;
+            {
+                std::unique_lock<std::mutex> lck(w->jobMtx);
+                w->jobCV.wait(lck, [w] { return !w->jobs.empty() || w->stop; });
+                if (w->stop) { break; }
+                job = w->jobs.front();
+            }
+
+            // Measure it on scratch buffers. Only threaded measurements need plannerMtx, to keep the thread count.
+            flog::info("Measuring the fastest FFT plan for size {0}", job.size);
+            measuring = true;
+            if (threadCount(job.size) > 1) {
+                std::lock_guard<std::mutex> lck(plannerMtx);
+                measure(job);
+            }
+            else {
+                measure(job);
+            }
+            measuring = false;
+            if (w->abandoned) { return; }
+
+            // Save the wisdom right away so it isn't lost if the program doesn't exit cleanly
+            {
+                std::lock_guard<std::mutex> lck(plannerMtx);
+                saveWisdom();
+            }
+            flog::info("Done measuring FFT size {0}", job.size);
+
+            {
+                std::lock_guard<std::mutex> lck(w->jobMtx);
+                w->jobs.pop_front();
+            }
+            wisdomGen++;
+        }
+
+        std::lock_guard<std::mutex> lck(w->jobMtx);
+        w->stopped = true;
+        w->doneCV.notify_all();
+    }
+
+    void init(const std::string& wisdomPath) {
+        if (_init) { return; }
+        _wisdomPath = wisdomPath;
+
+        // Load existing wisdom
+        if (fftwf_import_wisdom_from_filename(_wisdomPath.c_str())) {
+            flog::info("Loaded FFTW wisdom from {0}", _wisdomPath);
+        }
+
+#ifdef SDRPP_FFTW_THREADS
+        // Measuring in the background is only possible with a thread safe planner, otherwise only the wisdom is used
+        fftwf_init_threads();
+        fftwf_make_planner_thread_safe();
+        fftwf_plan_with_nthreads(1);
+
+        // Bound the time the planner is busy with a measurement since any other plan waits for it
+        fftwf_set_timelimit(FFT_PLAN_MEASURE_TIME_LIMIT);
+
+        worker = new Worker;
+        worker->thread = std::thread(workerLoop, worker);
+#endif
+
+        _init = true;
+    }
+
+    void end() {
+        if (!_init) { return; }
+        _init = false;
+
+        // Stop the worker, measurements that weren't done are simply dropped. One still running
+        // isn't waited for more than a moment so that it doesn't hold up the exit.
+        if (worker) {
+            std::unique_lock<std::mutex> lck(worker->jobMtx);
+            worker->stop = true;
+            worker->jobCV.notify_all();
+            if (worker->doneCV.wait_for(lck, std::chrono::milliseconds(FFT_PLAN_EXIT_TIMEOUT), [] { return worker->stopped; })) {
+                lck.unlock();
+                worker->thread.join();
+                delete worker;
+            }
+            else {
+                flog::warn("Abandoning the measurement of an FFT plan");
+                worker->abandoned = true;
+                lck.unlock();
+                worker->thread.detach();
+
+                // The wisdom can't be saved while the planner is in use and was already saved after the last measurement
+                worker = NULL;
+                return;
+            }
+            worker = NULL;
+        }
+
+        std::lock_guard<std::mutex> lck(plannerMtx);
+        saveWisdom();
+    }
+
+    fftwf_plan create(int size, fftwf_complex* in, fftwf_complex* out, int sign) {
+        std::lock_guard<std::mutex> lck(plannerMtx);
+
+        // Use the measured plan if the wisdom has one
+        fftwf_plan plan = planDFT(size, in, out, sign, FFTW_MEASURE | FFTW_WISDOM_ONLY);
+        if (plan) { return plan; }
+
+        // Otherwise get a plan immediately and have the best one measured in the background
+        plan = planDFT(size, in, out, sign, FFTW_ESTIMATE);
+        if (worker) {
+            std::lock_guard<std::mutex> lck2(worker->jobMtx);
+            auto& jobs = worker->jobs;
+            if (std::find_if(jobs.begin(), jobs.end(), [=](const Job& j) { return j.size == size && j.sign == sign; }) == jobs.end()) {
+                jobs.push_back({ size, sign });
+                worker->jobCV.notify_all();
+            }
+        }
+        return plan;
+    }
+
+    fftwf_plan createEstimate(int size, fftwf_complex* in, fftwf_complex* out, int sign) {
+        std::lock_guard<std::mutex> lck(plannerMtx);
+        return planDFT(size, in, out, sign, FFTW_ESTIMATE);
+    }
+
+    bool upgrade(fftwf_plan& plan, int size, fftwf_complex* in, fftwf_complex* out, int sign) {
+        // The planner would make the caller wait until the current measurement is done
+        if (measuring) { return false; }
+        std::unique_lock<std::mutex> lck(plannerMtx, std::try_to_lock);
+        if (!lck.owns_lock()) { return false; }
+
+        fftwf_plan newPlan = planDFT(size, in, out, sign, FFTW_MEASURE | FFTW_WISDOM_ONLY);
+        if (newPlan) {
+            fftwf_destroy_plan(plan);
+            plan = newPlan;
+        }
+        return true;
+    }
+
+    void destroy(fftwf_plan plan) {
+        if (!plan) { return; }
+        std::lock_guard<std::mutex> lck(plannerMtx);
+        fftwf_destroy_plan(plan);
+    }
+
+    bool wisdomChanged(uint64_t& generation) {
+        uint64_t gen = wisdomGen;
+        if (gen == generation) { return false; }
+        generation = gen;
+        return true;
+    }
+
+    // Make sure the worker is stopped even on exit paths that don't call end()
+    struct Cleanup {
+        ~Cleanup() { end(); }
+    } cleanup;
+}
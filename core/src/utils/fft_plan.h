@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <stdint.h>
+#include <fftw3.h>
+
+namespace fftplan {
+    /**
+     * Load the FFTW wisdom and start the background planner. Must be called before any plan is created.
+     * Measurements only run in the background when FFTW was built with threads, since they need a thread safe planner.
+     * A measurement is limited to a fraction of a second, any plan created meanwhile waits for it.
+     * @param wisdomPath Path of the file the wisdom is loaded from and saved to.
+    */
+    void init(const std::string& wisdomPath);
+
+    /**
+     * Stop the background planner and save the wisdom. A measurement still running is abandoned.
+    */
+    void end();
+
+    /**
+     * Create a complex 1D FFT plan. A measured plan is returned if the wisdom already knows the size,
+     * otherwise an estimated plan is returned and the size is measured in the background.
+     * The arrays may be overwritten. Large sizes are planned to use multiple threads if available.
+     * @param size Size of the FFT.
+     * @param in Input array.
+     * @param out Output array.
+     * @param sign FFTW_FORWARD or FFTW_BACKWARD.
+     * @return The plan, to be destroyed with fftplan::destroy().
+    */
+    fftwf_plan create(int size, fftwf_complex* in, fftwf_complex* out, int sign);
+
+    /**
+     * Create an estimated complex 1D FFT plan without ever measuring it. Every plan in the program must be created
+     * through fftplan so that the thread count of the FFTW planner is only changed by fftplan.
+     * The parameters are the same as fftplan::create().
+     * @return The plan, to be destroyed with fftplan::destroy().
+    */
+    fftwf_plan createEstimate(int size, fftwf_complex* in, fftwf_complex* out, int sign);
+
+    /**
+     * Replace a plan by a measured one if the wisdom has one, without ever waiting on the background planner.
+     * Meant to be called from DSP threads after fftplan::wisdomChanged() returned true.
+     * The arrays may be overwritten. The parameters must be the same as the ones the plan was created with.
+     * @param plan Plan to replace.
+     * @return False if the planner was busy and the call must be retried later, true otherwise.
+    */
+    bool upgrade(fftwf_plan& plan, int size, fftwf_complex* in, fftwf_complex* out, int sign);
+
+    /**
+     * Destroy a plan created with fftplan::create(). Does nothing if the plan is NULL.
+     * @param plan Plan to destroy.
+    */
+    void destroy(fftwf_plan plan);
+
+    /**
+     * Check if new wisdom was measured since the last call, meaning plans could be recreated faster.
+     * @param generation Generation of the wisdom the caller's plans were created with, updated by the call.
+     * @return True if the wisdom changed.
+    */
+    bool wisdomChanged(uint64_t& generation);
+}
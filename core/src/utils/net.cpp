@@ -2,6 +2,7 @@
 #include <string.h>
 #include <codecvt>
 #include <stdexcept>
+#include <algorithm>
 
 #ifdef _WIN32
 #define WOULD_BLOCK (WSAGetLastError() == WSAEWOULDBLOCK)
@@ -190,6 +191,100 @@ namespace net {
         return read;
     }
 
+    int Socket::recvBatch(uint8_t* data, int* lens, int count, size_t maxLen, int timeout) {
+        count = std::min<int>(count, NET_MAX_BATCH_SIZE);
+
+#ifdef __linux__
+        mmsghdr msgs[NET_MAX_BATCH_SIZE];
+        iovec iovs[NET_MAX_BATCH_SIZE];
+        uint8_t ctrl[NET_MAX_BATCH_SIZE][CMSG_SPACE(sizeof(uint32_t))];
+#endif
+
+        while (true) {
+            // Wait for the first datagram
+            if (timeout != NONBLOCKING) {
+                fd_set set;
+                FD_ZERO(&set);
+                FD_SET(sock, &set);
+                timeval tv;
+                tv.tv_sec = timeout / 1000;
+                tv.tv_usec = (timeout - tv.tv_sec*1000) * 1000;
+                int err = select(sock+1, &set, NULL, &set, (timeout > 0) ? &tv : NULL);
+                if (err <= 0) { return err; }
+            }
+
+#ifdef __linux__
+            // Receive everything that's queued in a single call
+            for (int i = 0; i < count; i++) {
+                iovs[i].iov_base = &data[i * maxLen];
+                iovs[i].iov_len = maxLen;
+                memset(&msgs[i].msg_hdr, 0, sizeof(msghdr));
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                msgs[i].msg_hdr.msg_control = ctrl[i];
+                msgs[i].msg_hdr.msg_controllen = sizeof(ctrl[i]);
+            }
+            int n = recvmmsg(sock, msgs, count, MSG_DONTWAIT, NULL);
+            if (n <= 0) {
+                // The datagram select() saw may have been discarded since, for example because of a bad checksum
+                if (WOULD_BLOCK) {
+                    if (timeout != NONBLOCKING) { continue; }
+                    return -1;
+                }
+                close();
+                return n;
+            }
+
+            // Get the lengths and the drop counter maintained by the kernel
+            for (int i = 0; i < n; i++) {
+                lens[i] = msgs[i].msg_len;
+                for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+                    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+                        memcpy(&kernelDrops, CMSG_DATA(cmsg), sizeof(uint32_t));
+                    }
+                }
+            }
+            return n;
+#else
+            // Receive one datagram at a time as long as some are queued
+            int n = 0;
+            while (n < count) {
+                if (n) {
+                    fd_set set;
+                    FD_ZERO(&set);
+                    FD_SET(sock, &set);
+                    timeval tv = { 0, 0 };
+                    if (select(sock+1, &set, NULL, NULL, &tv) <= 0) { break; }
+                }
+                int err = ::recvfrom(sock, (char*)&data[n * maxLen], maxLen, 0, NULL, NULL);
+                if (err <= 0) {
+                    if (!WOULD_BLOCK) {
+                        close();
+                        return n ? n : err;
+                    }
+                    break;
+                }
+                lens[n++] = err;
+            }
+
+            // Same as above, wait again if the datagram select() saw is gone
+            if (!n) {
+                if (timeout != NONBLOCKING) { continue; }
+                return -1;
+            }
+            return n;
+#endif
+        }
+    }
+
+    bool Socket::setRecvBufferSize(int size) {
+        return !setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char*)&size, sizeof(int));
+    }
+
+    uint64_t Socket::getDropped() {
+        return kernelDrops;
+    }
+
     int Socket::recvline(std::string& str, int maxLen, int timeout, Address* dest) {
         // Disallow nonblocking mode
         if (!timeout) { return -1; }
@@ -403,6 +498,12 @@ namespace net {
             return NULL;
         }
 
+#ifdef __linux__
+        // Have the kernel report how many datagrams it dropped, not fatal if unsupported
+        int ovfl = 1;
+        setsockopt(s, SOL_SOCKET, SO_RXQ_OVFL, &ovfl, sizeof(int));
+#endif
+
         // Bind socket to local port
         if (bind(s, (sockaddr*)&laddr.addr, sizeof(sockaddr_in))) {
             closeSocket(s);
@@ -22,6 +22,12 @@
 #include <ifaddrs.h>
 #endif
 
+// Largest number of datagrams received by a single call to Socket::recvBatch
+#define NET_MAX_BATCH_SIZE      128
+
+// Receive buffer size recommended for high rate UDP streams
+#define NET_UDP_RECV_BUFFER     (8 * 1024 * 1024)
+
 namespace net {
 #ifdef _WIN32
     typedef SOCKET SockHandle_t;
@@ -169,10 +175,35 @@ namespace net {
          */
         int recvline(std::string& str, int maxLen = 0, int timeout = NO_TIMEOUT, Address* dest = NULL);
 
+        /**
+         * Receive multiple datagrams with as few system calls as possible. Waits for the first datagram, then takes all that are already queued.
+         * @param data Buffer to read the datagrams into, datagram i is written at offset i * maxLen.
+         * @param lens Array that receives the length of each datagram.
+         * @param count Maximum number of datagrams to receive, no more than NET_MAX_BATCH_SIZE.
+         * @param maxLen Maximum length of a datagram.
+         * @param timeout Timeout in milliseconds. Use NO_TIMEOUT or NONBLOCKING here if needed.
+         * @return Number of datagrams received. 0 means timed out or closed. -1 means error, or would block in nonblocking mode.
+         */
+        int recvBatch(uint8_t* data, int* lens, int count, size_t maxLen, int timeout = NO_TIMEOUT);
+
+        /**
+         * Set the size of the receive buffer of the OS. The OS may use a smaller size than requested.
+         * @param size Size in bytes.
+         * @return True on success, false otherwise.
+         */
+        bool setRecvBufferSize(int size);
+
+        /**
+         * Get the number of datagrams dropped by the OS because the receive buffer was full. Only supported on Linux.
+         * @return Number of dropped datagrams since the socket was opened.
+         */
+        uint64_t getDropped();
+
     private:
         Address* raddr = NULL;
         SockHandle_t sock;
         bool open = true;
+        uint32_t kernelDrops = 0;
 
     };
 
@@ -4,8 +4,12 @@
 
 namespace riff {
     const char* RIFF_SIGNATURE      = "RIFF";
+    const char* RF64_SIGNATURE      = "RF64";
+    const char* DS64_SIGNATURE      = "ds64";
+    const char* DATA_SIGNATURE      = "data";
     const char* LIST_SIGNATURE      = "LIST";
     const size_t RIFF_LABEL_SIZE    = 4;
+    const uint32_t RF64_SIZE_MARKER = 0xFFFFFFFF;
 
     // Writer::Writer(const Writer&& b) {
     //     //file = std::move(b.file);
@@ -15,12 +19,13 @@ namespace riff {
         close();
     }
 
-    bool Writer::open(std::string path, const char form[4]) {
+    bool Writer::open(std::string path, const char form[4], bool rf64) {
         std::lock_guard<std::recursive_mutex> lck(mtx);
 
         // Open file
         file = std::ofstream(path, std::ios::out | std::ios::binary);
         if (!file.is_open()) { return false; }
+        _rf64 = rf64;
 
         // Begin RIFF chunk
         beginRIFF(form);
@@ -74,6 +79,7 @@ namespace riff {
         desc.pos = file.tellp();
         memcpy(desc.hdr.id, id, sizeof(desc.hdr.id));
         desc.hdr.size = 0;
+        desc.size = 0;
         file.write((char*)&desc.hdr, sizeof(ChunkHeader));
 
         // Save descriptor
@@ -91,17 +97,29 @@ namespace riff {
         ChunkDesc desc = chunks.top();
         chunks.pop();
 
+        // In RF64 mode, the RIFF and data chunks get their real size in the ds64 chunk
+        bool isRIFF = chunks.empty();
+        bool isData = !memcmp(desc.hdr.id, DATA_SIGNATURE, RIFF_LABEL_SIZE);
+        if (_rf64 && isRIFF) { ds64.riffSize = desc.size; }
+        if (_rf64 && isData) { ds64.dataSize = desc.size; }
+        bool inDS64 = _rf64 && (isRIFF || isData);
+        desc.hdr.size = (inDS64 || desc.size > RF64_SIZE_MARKER) ? RF64_SIZE_MARKER : desc.size;
+
         // Write size
         auto pos = file.tellp();
         auto npos = desc.pos;
         npos += 4;
         file.seekp(npos);
         file.write((char*)&desc.hdr.size, sizeof(desc.hdr.size));
+        if (_rf64 && isRIFF) {
+            file.seekp(ds64Pos);
+            file.write((char*)&ds64, sizeof(DS64Chunk));
+        }
         file.seekp(pos);
 
         // If parent chunk, increment its size by the size of the sub-chunk plus the size of its header)
         if (!chunks.empty()) {
-            chunks.top().hdr.size += desc.hdr.size + sizeof(ChunkHeader);
+            chunks.top().size += desc.size + sizeof(ChunkHeader);
         }
     }
 
@@ -112,7 +130,7 @@ namespace riff {
             throw std::runtime_error("No chunk to write into");
         }
         file.write((char*)data, len);
-        chunks.top().hdr.size += len;
+        chunks.top().size += len;
     }
 
     void Writer::beginRIFF(const char form[4]) {
@@ -123,8 +141,17 @@ namespace riff {
         }
 
         // Create chunk with RIFF ID and write form
-        beginChunk(RIFF_SIGNATURE);
+        beginChunk(_rf64 ? RF64_SIGNATURE : RIFF_SIGNATURE);
         write((uint8_t*)form, RIFF_LABEL_SIZE);
+
+        // Reserve the ds64 chunk, it's filled in once all sizes are known
+        if (_rf64) {
+            memset(&ds64, 0, sizeof(DS64Chunk));
+            beginChunk(DS64_SIGNATURE);
+            ds64Pos = file.tellp();
+            write((uint8_t*)&ds64, sizeof(DS64Chunk));
+            endChunk();
+        }
     }
 
     void Writer::endRIFF() {
@@ -133,7 +160,7 @@ namespace riff {
         if (chunks.empty()) {
             throw std::runtime_error("No chunk to end");
         }
-        if (memcmp(chunks.top().hdr.id, RIFF_SIGNATURE, RIFF_LABEL_SIZE)) {
+        if (memcmp(chunks.top().hdr.id, _rf64 ? RF64_SIGNATURE : RIFF_SIGNATURE, RIFF_LABEL_SIZE)) {
             throw std::runtime_error("Top chunk not RIFF chunk");
         }
 
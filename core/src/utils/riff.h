@@ -11,10 +11,19 @@ namespace riff {
         char id[4];
         uint32_t size;
     };
+
+    // Sizes of a RF64 file, stored in the ds64 chunk since they may not fit in the chunk headers
+    struct DS64Chunk {
+        uint64_t riffSize;
+        uint64_t dataSize;
+        uint64_t sampleCount;
+        uint32_t tableLength;
+    };
 #pragma pack(pop)
 
     struct ChunkDesc {
         ChunkHeader hdr;
+        uint64_t size;
         std::streampos pos;
     };
 
@@ -24,7 +33,8 @@ namespace riff {
         // Writer(const Writer&& b);
         ~Writer();
 
-        bool open(std::string path, const char form[4]);
+        // In RF64 mode, chunks that are too big for a RIFF file are allowed and their size is stored in a ds64 chunk
+        bool open(std::string path, const char form[4], bool rf64 = false);
         bool isOpen();
         void close();
 
@@ -43,6 +53,10 @@ namespace riff {
         std::recursive_mutex mtx;
         std::ofstream file;
         std::stack<ChunkDesc> chunks;
+
+        bool _rf64 = false;
+        std::streampos ds64Pos;
+        DS64Chunk ds64;
     };
 
     // class Reader {
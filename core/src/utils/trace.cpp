@@ -0,0 +1,174 @@
+#include <utils/trace.h>
+#include <utils/flog.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <deque>
+#include <chrono>
+
+namespace trace {
+    enum EventType {
+        EVENT_COMPLETE,
+        EVENT_INSTANT
+    };
+
+    struct Event {
+        uint64_t start;
+        uint64_t end;
+        EventType type;
+        char name[TRACE_NAME_SIZE];
+    };
+
+    struct ThreadBuffer {
+        int id;
+        char name[TRACE_NAME_SIZE];
+        Event events[TRACE_BUFFER_EVENTS];
+        std::atomic<uint64_t> count = { 0 };
+    };
+
+    std::atomic<bool> enabled = { false };
+    uint64_t startTime = 0;
+
+    // Buffers outlive their thread so that events of threads that already exited still get dumped. They are
+    // handed to new threads once their own thread is gone, the one freed the longest ago first.
+    std::mutex buffersMtx;
+    std::vector<ThreadBuffer*> buffers;
+    std::deque<ThreadBuffer*> freeBuffers;
+    int nextId = 1;
+    thread_local ThreadBuffer* current = NULL;
+    thread_local char pendingName[TRACE_NAME_SIZE] = "";
+
+    // Gives the buffer of the thread back when it exits
+    struct BufferRelease {
+        ThreadBuffer* buf = NULL;
+        ~BufferRelease() {
+            if (!buf) { return; }
+            std::lock_guard<std::mutex> lck(buffersMtx);
+            freeBuffers.push_back(buf);
+        }
+    };
+    thread_local BufferRelease release;
+
+    ThreadBuffer* getBuffer() {
+        if (current) { return current; }
+        {
+            std::lock_guard<std::mutex> lck(buffersMtx);
+            if (freeBuffers.empty()) {
+                current = new ThreadBuffer;
+                buffers.push_back(current);
+            }
+            else {
+                current = freeBuffers.front();
+                freeBuffers.pop_front();
+                current->count = 0;
+            }
+            current->id = nextId++;
+            strncpy(current->name, pendingName, TRACE_NAME_SIZE - 1);
+            current->name[TRACE_NAME_SIZE - 1] = 0;
+        }
+        release.buf = current;
+        return current;
+    }
+
+    void push(const char* name, uint64_t start, uint64_t end, EventType type) {
+        ThreadBuffer* buf = getBuffer();
+        uint64_t count = buf->count.load(std::memory_order_relaxed);
+        Event& ev = buf->events[count % TRACE_BUFFER_EVENTS];
+        ev.start = start;
+        ev.end = end;
+        ev.type = type;
+        strncpy(ev.name, name, TRACE_NAME_SIZE - 1);
+        ev.name[TRACE_NAME_SIZE - 1] = 0;
+        buf->count.store(count + 1, std::memory_order_release);
+    }
+
+    void start() {
+        startTime = now();
+        enabled = true;
+    }
+
+    void stop() {
+        enabled = false;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+    void setThreadName(const char* name) {
+        // Threads get their buffer on their first event, remember the name until then
+        char* dst = current ? current->name : pendingName;
+        strncpy(dst, name, TRACE_NAME_SIZE - 1);
+        dst[TRACE_NAME_SIZE - 1] = 0;
+    }
+
+    void complete(const char* name, uint64_t start, uint64_t end) {
+        if (!enabled) { return; }
+        push(name, start, end, EVENT_COMPLETE);
+    }
+
+    void instant(const char* name) {
+        if (!enabled) { return; }
+        uint64_t t = now();
+        push(name, t, t, EVENT_INSTANT);
+    }
+
+    void writeString(FILE* file, const char* str) {
+        fputc('"', file);
+        for (; *str; str++) {
+            if (*str == '"' || *str == '\\') { fputc('\\', file); }
+            if ((unsigned char)*str < 0x20) { continue; }
+            fputc(*str, file);
+        }
+        fputc('"', file);
+    }
+
+    bool dump(std::string path) {
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            flog::error("Could not open '{0}' to write the trace", path);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lck(buffersMtx);
+        fprintf(file, "{\"traceEvents\":[\n");
+        bool first = true;
+        uint64_t total = 0;
+        for (auto& buf : buffers) {
+            // Thread name metadata
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", buf->id);
+            writeString(file, buf->name[0] ? buf->name : "Thread");
+            fprintf(file, "}}");
+            first = false;
+
+            // Only the last TRACE_BUFFER_EVENTS events are still there
+            uint64_t count = buf->count.load(std::memory_order_acquire);
+            uint64_t begin = (count > TRACE_BUFFER_EVENTS) ? (count - TRACE_BUFFER_EVENTS) : 0;
+            for (uint64_t i = begin; i < count; i++) {
+                Event& ev = buf->events[i % TRACE_BUFFER_EVENTS];
+                if (ev.start < startTime) { continue; }
+                fprintf(file, ",\n{\"name\":");
+                writeString(file, ev.name);
+                double ts = (double)(ev.start - startTime) / 1000.0;
+                if (ev.type == EVENT_COMPLETE) {
+                    fprintf(file, ",\"ph\":\"X\",\"ts\":%.3lf,\"dur\":%.3lf,\"pid\":1,\"tid\":%d}", ts, (double)(ev.end - ev.start) / 1000.0, buf->id);
+                }
+                else {
+                    fprintf(file, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3lf,\"pid\":1,\"tid\":%d}", ts, buf->id);
+                }
+                total++;
+            }
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+
+        flog::info("Wrote {0} trace events to '{1}'", total, path);
+        return true;
+    }
+
+    uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
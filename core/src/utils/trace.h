@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+// Number of events kept per thread, the oldest ones are overwritten when full
+#define TRACE_BUFFER_EVENTS     16384
+
+// Longest event name kept, including the terminating null
+#define TRACE_NAME_SIZE         48
+
+// Chrome trace (chrome://tracing, Perfetto) recording of what each thread is doing. Only compiled in
+// when building with OPT_TRACING, the TRACE_ macros expand to nothing otherwise. Each thread writes to
+// its own buffer without any locking, the buffers are only read when dumping after stop(). The buffer
+// of a thread that exited is reused by the next new thread, dropping its events.
+namespace trace {
+    void start();
+    void stop();
+    bool isEnabled();
+
+    // Name of the calling thread in the trace
+    void setThreadName(const char* name);
+
+    // Record an event that lasted from start to end, in nanoseconds from now()
+    void complete(const char* name, uint64_t start, uint64_t end);
+
+    // Record an event without duration
+    void instant(const char* name);
+
+    // Write all events to a Chrome trace JSON file
+    bool dump(std::string path);
+
+    uint64_t now();
+
+    class Scope {
+    public:
+        Scope(const char* name) {
+            if (!isEnabled()) { return; }
+            _name = name;
+            start = now();
+        }
+
+        ~Scope() {
+            if (_name) { complete(_name, start, now()); }
+        }
+
+    private:
+        const char* _name = NULL;
+        uint64_t start = 0;
+    };
+}
+
+#ifdef SDRPP_TRACING
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(_traceScope, __LINE__)(name)
+#define TRACE_INSTANT(name) trace::instant(name)
+#define TRACE_THREAD_NAME(name) trace::setThreadName(name)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_INSTANT(name)
+#define TRACE_THREAD_NAME(name)
+#endif
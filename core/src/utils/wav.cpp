@@ -4,6 +4,7 @@
 #include <dsp/buffer/buffer.h>
 #include <dsp/stream.h>
 #include <map>
+#include <chrono>
 
 namespace wav {
     const char* WAVE_FILE_TYPE          = "WAVE";
@@ -40,6 +41,7 @@ namespace wav {
 
         // Reset work values
         samplesWritten = 0;
+        droppedBlocks = 0;
 
         // Fill header
         bytesPerSamp = (SAMP_BITS[_type] / 8) * _channels;
@@ -67,9 +69,11 @@ namespace wav {
             return false;
             break;
         }
+        bufF32 = dsp::buffer::alloc<float>(STREAM_BUFFER_SIZE * _channels);
+        queue.init(std::max<int>(_samplerate * WAV_WRITER_QUEUE_TIME, STREAM_BUFFER_SIZE * 4) * _channels);
 
         // Open file
-        if (!rw.open(path, WAVE_FILE_TYPE)) { return false; }
+        if (!rw.open(path, WAVE_FILE_TYPE, _format == FORMAT_RF64)) { return false; }
 
         // Write format chunk
         rw.beginChunk(FORMAT_MARKER);
@@ -78,6 +82,10 @@ namespace wav {
 
         // Begin data chunk
         rw.beginChunk(DATA_MARKER);
+
+        // Start the thread that does the disk I/O
+        stopWorker = false;
+        workerThread = std::thread(&Writer::worker, this);
         
         return true;
     }
@@ -92,6 +100,11 @@ namespace wav {
         // Do nothing if the file is not open
         if (!rw.isOpen()) { return; }
 
+        // Let the writer thread empty the queue and stop
+        stopWorker = true;
+        queueCnd.notify_one();
+        if (workerThread.joinable()) { workerThread.join(); }
+
         // Finish data chunk
         rw.endChunk();
 
@@ -111,6 +124,10 @@ namespace wav {
             dsp::buffer::free(bufI32);
             bufI32 = NULL;
         }
+        if (bufF32) {
+            dsp::buffer::free(bufF32);
+            bufF32 = NULL;
+        }
     }
 
     void Writer::setChannels(int channels) {
@@ -150,7 +167,32 @@ namespace wav {
     void Writer::write(float* samples, int count) {
         std::lock_guard<std::recursive_mutex> lck(mtx);
         if (!rw.isOpen()) { return; }
-        
+
+        // Drop the whole block rather than part of it so that the channels stay aligned
+        int tcount = count * _channels;
+        if (queue.getWritable() < tcount) {
+            droppedBlocks++;
+            return;
+        }
+        queue.write(samples, tcount);
+        queueCnd.notify_one();
+    }
+
+    void Writer::worker() {
+        while (true) {
+            // Only stop once everything that was queued has been written
+            int count = queue.read(bufF32, STREAM_BUFFER_SIZE * _channels);
+            if (!count) {
+                if (stopWorker) { break; }
+                std::unique_lock<std::mutex> lck(queueMtx);
+                queueCnd.wait_for(lck, std::chrono::milliseconds(10));
+                continue;
+            }
+            writeSamples(bufF32, count / _channels);
+        }
+    }
+
+    void Writer::writeSamples(float* samples, int count) {
         // Select different writer function depending on the chose depth
         int tcount = count * _channels;
         int tbytes = count * bytesPerSamp;
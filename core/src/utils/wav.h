@@ -3,8 +3,15 @@
 #include <fstream>
 #include <stdint.h>
 #include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <dsp/buffer/spsc_ring.h>
 #include "riff.h"
 
+// Duration of samples that can be queued up for the writer thread before blocks get dropped
+#define WAV_WRITER_QUEUE_TIME   0.5
+
 namespace wav {    
     #pragma pack(push, 1)
     struct FormatHeader {
@@ -49,10 +56,16 @@ namespace wav {
         void setSampleType(SampleType type);
 
         size_t getSamplesWritten() { return samplesWritten; }
+        size_t getDroppedBlocks() { return droppedBlocks; }
 
+        // Queue samples for the writer thread, never waits for the disk. If the queue is full,
+        // the block is dropped and counted instead.
         void write(float* samples, int count);
 
     private:
+        void worker();
+        void writeSamples(float* samples, int count);
+
         std::recursive_mutex mtx;
         FormatHeader hdr;
         riff::Writer rw;
@@ -66,6 +79,14 @@ namespace wav {
         uint8_t* bufU8 = NULL;
         int16_t* bufI16 = NULL;
         int32_t* bufI32 = NULL;
-        size_t samplesWritten = 0;
+        float* bufF32 = NULL;
+        std::atomic<size_t> samplesWritten = { 0 };
+        std::atomic<size_t> droppedBlocks = { 0 };
+
+        dsp::buffer::SPSCRing<float> queue;
+        std::thread workerThread;
+        std::mutex queueMtx;
+        std::condition_variable queueCnd;
+        std::atomic<bool> stopWorker = { false };
     };
 }
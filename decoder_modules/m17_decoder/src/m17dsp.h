@@ -11,13 +11,33 @@
 
 extern "C" {
 #include <correct.h>
+#ifdef HAVE_SSE
+#include <correct-sse.h>
+#endif
 }
 
+// Use the SSE Viterbi decoder when libcorrect was built with it
+#ifdef HAVE_SSE
+#define M17_CONV_TYPE           correct_convolutional_sse
+#define M17_CONV_CREATE         correct_convolutional_sse_create
+#define M17_CONV_DESTROY        correct_convolutional_sse_destroy
+#define M17_CONV_DECODE_SOFT    correct_convolutional_sse_decode_soft
+#else
+#define M17_CONV_TYPE           correct_convolutional
+#define M17_CONV_CREATE         correct_convolutional_create
+#define M17_CONV_DESTROY        correct_convolutional_destroy
+#define M17_CONV_DECODE_SOFT    correct_convolutional_decode_soft
+#endif
+
 #define M17_DEVIATION     2400.0f
 #define M17_BAUDRATE      4800.0f
 #define M17_RRC_ALPHA     0.5f
 #define M17_4FSK_HIGH_CUT ((1.0f + (1.0f/3.0f)) / 2.0f)
 
+// Soft bits go from 0 to 255, 128 being an erasure. Symbols at their nominal value give a certain bit.
+#define M17_SOFT_SCALE    384.0f
+#define M17_SOFT_ERASURE  128
+
 #define M17_SYNC_SIZE            16
 #define M17_LICH_SIZE            96
 #define M17_PAYLOAD_SIZE         144
@@ -120,11 +140,12 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
+            // Output soft bits, their distance to the decision threshold is the confidence
             float val;
             for (int i = 0; i < count; i++) {
                 val = _in->readBuf[i];
-                out.writeBuf[i * 2] = (val < 0.0f);
-                out.writeBuf[(i * 2) + 1] = (fabsf(val) > M17_4FSK_HIGH_CUT);
+                out.writeBuf[i * 2] = softBit(-val * M17_SOFT_SCALE);
+                out.writeBuf[(i * 2) + 1] = softBit((fabsf(val) - M17_4FSK_HIGH_CUT) * M17_SOFT_SCALE);
             }
 
             _in->flush();
@@ -136,6 +157,10 @@ namespace dsp {
         stream<uint8_t> out;
 
     private:
+        static inline uint8_t softBit(float llr) {
+            return std::clamp<int>(M17_SOFT_ERASURE + (int)llr, 0, 255);
+        }
+
         stream<float>* _in;
     };
 
@@ -149,12 +174,14 @@ namespace dsp {
             if (!block::_block_init) { return; }
             block::stop();
             delete[] delay;
+            delete[] hardDelay;
         }
 
         void init(stream<uint8_t>* in) {
             _in = in;
 
             delay = new uint8_t[STREAM_BUFFER_SIZE];
+            hardDelay = new uint8_t[STREAM_BUFFER_SIZE];
 
             block::registerInput(_in);
             block::registerOutput(&linkSetupOut);
@@ -178,7 +205,11 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
+            // Keep the soft bits for the decoders and hard decisions for the syncword detection
             memcpy(&delay[M17_SYNC_SIZE], _in->readBuf, count);
+            for (int i = 0; i < count; i++) {
+                hardDelay[M17_SYNC_SIZE + i] = (_in->readBuf[i] >= M17_SOFT_ERASURE);
+            }
 
             for (int i = 0; i < count;) {
                 if (detect) {
@@ -189,17 +220,20 @@ namespace dsp {
                     else {
                         int id = M17_INTERLEAVER[outCount - M17_SYNC_SIZE];
 
+                        // Descrambling a soft bit means mirroring it
+                        uint8_t bit = M17_SCRAMBLER[outCount - M17_SYNC_SIZE] ? (255 - delay[i++]) : delay[i++];
+
                         if (type == 0) {
-                            linkSetupOut.writeBuf[id] = delay[i++] ^ M17_SCRAMBLER[outCount - M17_SYNC_SIZE];
+                            linkSetupOut.writeBuf[id] = bit;
                         }
                         else if ((type == 1 || type == 2) && id < M17_LICH_SIZE) {
-                            lichOut.writeBuf[id] = delay[i++] ^ M17_SCRAMBLER[outCount - M17_SYNC_SIZE];
+                            lichOut.writeBuf[id] = (bit >= M17_SOFT_ERASURE);
                         }
                         else if (type == 1) {
-                            streamOut.writeBuf[id - M17_LICH_SIZE] = (delay[i++] ^ M17_SCRAMBLER[outCount - M17_SYNC_SIZE]);
+                            streamOut.writeBuf[id - M17_LICH_SIZE] = bit;
                         }
                         else if (type == 2) {
-                            packetOut.writeBuf[id - M17_LICH_SIZE] = (delay[i++] ^ M17_SCRAMBLER[outCount - M17_SYNC_SIZE]);
+                            packetOut.writeBuf[id - M17_LICH_SIZE] = bit;
                         }
 
                         outCount++;
@@ -223,7 +257,7 @@ namespace dsp {
                 }
 
                 // Check for link setup syncword
-                if (!memcmp(&delay[i], M17_LSF_SYNC, M17_SYNC_SIZE)) {
+                if (!memcmp(&hardDelay[i], M17_LSF_SYNC, M17_SYNC_SIZE)) {
                     detect = true;
                     outCount = 0;
                     type = 0;
@@ -232,7 +266,7 @@ namespace dsp {
                 }
 
                 // Check for stream syncword
-                if (!memcmp(&delay[i], M17_STF_SYNC, M17_SYNC_SIZE)) {
+                if (!memcmp(&hardDelay[i], M17_STF_SYNC, M17_SYNC_SIZE)) {
                     detect = true;
                     outCount = 0;
                     type = 1;
@@ -241,7 +275,7 @@ namespace dsp {
                 }
 
                 // Check for packet syncword
-                if (!memcmp(&delay[i], M17_PKF_SYNC, M17_SYNC_SIZE)) {
+                if (!memcmp(&hardDelay[i], M17_PKF_SYNC, M17_SYNC_SIZE)) {
                     detect = true;
                     outCount = 0;
                     type = 2;
@@ -253,6 +287,7 @@ namespace dsp {
             }
 
             memmove(delay, &delay[count], 16);
+            memmove(hardDelay, &hardDelay[count], 16);
 
             _in->flush();
 
@@ -268,6 +303,7 @@ namespace dsp {
         stream<uint8_t>* _in;
 
         uint8_t* delay;
+        uint8_t* hardDelay;
 
         bool detect = false;
         int type;
@@ -284,7 +320,7 @@ namespace dsp {
         ~M17LSFDecoder() {
             if (!block::_block_init) { return; }
             block::stop();
-            correct_convolutional_destroy(conv);
+            M17_CONV_DESTROY(conv);
         }
 
         void init(stream<uint8_t>* in, void (*handler)(M17LSF& lsf, void* ctx), void* ctx) {
@@ -292,7 +328,7 @@ namespace dsp {
             _handler = handler;
             _ctx = ctx;
 
-            conv = correct_convolutional_create(2, 5, correct_conv_m17_polynomial);
+            conv = M17_CONV_CREATE(2, 5, correct_conv_m17_polynomial);
 
             block::registerInput(_in);
             block::_block_init = true;
@@ -312,11 +348,11 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
-            // Depuncture the data
+            // Depuncture the data, punctured bits are erasures
             int inOffset = 0;
             for (int i = 0; i < M17_ENCODED_LSF_SIZE; i++) {
                 if (!M17_PUNCTURING_P1[i % 61]) {
-                    depunctured[i] = 0;
+                    depunctured[i] = M17_SOFT_ERASURE;
                     continue;
                 }
                 depunctured[i] = _in->readBuf[inOffset++];
@@ -324,14 +360,8 @@ namespace dsp {
 
             _in->flush();
 
-            // Pack into bytes
-            memset(packed, 0, 61);
-            for (int i = 0; i < M17_ENCODED_LSF_SIZE; i++) {
-                packed[i / 8] |= depunctured[i] << (7 - (i % 8));
-            }
-
-            // Run through convolutional decoder
-            correct_convolutional_decode(conv, packed, M17_ENCODED_LSF_SIZE, lsf);
+            // Run through soft decision convolutional decoder
+            M17_CONV_DECODE_SOFT(conv, depunctured, M17_ENCODED_LSF_SIZE, lsf);
 
             // Decode it and call the handler
             M17LSF decLsf = M17DecodeLSF(lsf);
@@ -347,10 +377,9 @@ namespace dsp {
         void* _ctx;
 
         uint8_t depunctured[488];
-        uint8_t packed[61];
         uint8_t lsf[30];
 
-        correct_convolutional* conv;
+        M17_CONV_TYPE* conv;
     };
 
     class M17PayloadFEC : public block {
@@ -362,13 +391,13 @@ namespace dsp {
         ~M17PayloadFEC() {
             if (!block::_block_init) { return; }
             block::stop();
-            correct_convolutional_destroy(conv);
+            M17_CONV_DESTROY(conv);
         }
 
         void init(stream<uint8_t>* in) {
             _in = in;
 
-            conv = correct_convolutional_create(2, 5, correct_conv_m17_polynomial);
+            conv = M17_CONV_CREATE(2, 5, correct_conv_m17_polynomial);
 
             block::registerInput(_in);
             block::registerOutput(&out);
@@ -389,25 +418,18 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
-            // Depuncture the data
+            // Depuncture the data, punctured bits are erasures
             int inOffset = 0;
             for (int i = 0; i < M17_ENCODED_PAYLOAD_SIZE; i++) {
                 if (!M17_PUNCTURING_P2[i % 12]) {
-                    depunctured[i] = 0;
+                    depunctured[i] = M17_SOFT_ERASURE;
                     continue;
                 }
                 depunctured[i] = _in->readBuf[inOffset++];
             }
 
-            // Pack into bytes
-            memset(packed, 0, 37);
-            for (int i = 0; i < M17_ENCODED_PAYLOAD_SIZE; i++) {
-                if (!(i % 8)) { packed[i / 8] = 0; }
-                packed[i / 8] |= depunctured[i] << (7 - (i % 8));
-            }
-
-            // Run through convolutional decoder
-            correct_convolutional_decode(conv, packed, M17_ENCODED_PAYLOAD_SIZE, out.writeBuf);
+            // Run through soft decision convolutional decoder
+            M17_CONV_DECODE_SOFT(conv, depunctured, M17_ENCODED_PAYLOAD_SIZE, out.writeBuf);
 
             _in->flush();
 
@@ -421,9 +443,8 @@ namespace dsp {
         stream<uint8_t>* _in;
 
         uint8_t depunctured[296];
-        uint8_t packed[37];
 
-        correct_convolutional* conv;
+        M17_CONV_TYPE* conv;
     };
 
     class M17Codec2Decode : public block {
@@ -8,6 +8,15 @@
 #define POCSAG_DATA_BITS_PER_CW     20
 
 #define POCSAG_GEN_POLY             ((uint32_t)(0b11101101001))
+#define POCSAG_BCH_PARITY_BITS      10
+#define POCSAG_BCH_CODE_BITS        31
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define POPCOUNT(x) __popcnt(x)
+#else
+#define POPCOUNT(x) __builtin_popcount(x)
+#endif
 
 namespace pocsag {
     const char NUMERIC_CHARSET[] = {
@@ -29,6 +38,36 @@ namespace pocsag {
         '['
     };
 
+    // Remainder of the 31bit BCH part of a codeword divided by the generator polynomial
+    inline uint32_t bchSyndrome(uint32_t code) {
+        for (int i = POCSAG_BCH_CODE_BITS - 1; i >= POCSAG_BCH_PARITY_BITS; i--) {
+            if ((code >> i) & 1) { code ^= POCSAG_GEN_POLY << (i - POCSAG_BCH_PARITY_BITS); }
+        }
+        return code;
+    }
+
+    // Table giving the error pattern of every correctable syndrome, zero if the syndrome isn't correctable
+    struct SyndromeTable {
+        SyndromeTable() {
+            memset(patterns, 0, sizeof(patterns));
+            for (int i = 0; i < POCSAG_BCH_CODE_BITS; i++) {
+                // Single bit errors
+                uint32_t single = (uint32_t)1 << i;
+                patterns[bchSyndrome(single)] = single;
+
+                // Double bit errors
+                for (int j = i + 1; j < POCSAG_BCH_CODE_BITS; j++) {
+                    uint32_t pattern = single | ((uint32_t)1 << j);
+                    patterns[bchSyndrome(pattern)] = pattern;
+                }
+            }
+        }
+
+        uint32_t patterns[1 << POCSAG_BCH_PARITY_BITS];
+    };
+
+    const SyndromeTable SYNDROME_TABLE;
+
     Decoder::Decoder() {
         // Zero out batch
         memset(batch, 0, sizeof(batch));
@@ -68,18 +107,28 @@ namespace pocsag {
     }
 
     int Decoder::distance(uint32_t a, uint32_t b) {
-        uint32_t diff = a ^ b;
-        int dist = 0;
-        for (int i = 0; i < 32; i++) {
-            dist += (diff >> i ) & 1;
-        }
-        return dist;
+        return POPCOUNT(a ^ b);
     }
 
     bool Decoder::correctCodeword(Codeword in, Codeword& out) {
+        // The BCH(31,21) code covers all bits except the last one which is an even parity bit
+        uint32_t syndrome = bchSyndrome(in >> 1);
+        int errors = 0;
+        out = in;
+        if (syndrome) {
+            uint32_t pattern = SYNDROME_TABLE.patterns[syndrome];
+            if (!pattern) { return false; }
+            out ^= pattern << 1;
+            errors = POPCOUNT(pattern);
+        }
 
+        // If the parity doesn't match after correction, the parity bit is also wrong, which is only fine for up to 2 errors in total
+        if (POPCOUNT(out) & 1) {
+            if (errors >= 2) { return false; }
+            out ^= 1;
+        }
 
-        return true; // TODO
+        return true;
     }
 
     void Decoder::flushMessage() {
@@ -108,12 +157,16 @@ namespace pocsag {
     }
 
     void Decoder::decodeBatch() {
+        // Correct the whole batch first
+        bool valid[POCSAG_BATCH_CODEWORD_COUNT];
         for (int i = 0; i < POCSAG_BATCH_CODEWORD_COUNT; i++) {
-            // Get codeword
-            Codeword cw = batch[i];
+            valid[i] = correctCodeword(batch[i], batch[i]);
+        }
 
-            // Correct errors. If corrupted, skip
-            if (!correctCodeword(cw, cw)) { continue; }
+        for (int i = 0; i < POCSAG_BATCH_CODEWORD_COUNT; i++) {
+            // Get codeword, skip it if it was too corrupted
+            Codeword cw = batch[i];
+            if (!valid[i]) { continue; }
             // TODO: End message if two consecutive are corrupt
 
             // Get codeword type
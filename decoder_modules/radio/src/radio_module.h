@@ -78,6 +78,9 @@ public:
         ifChain.addBlock(&squelch, false);
         ifChain.addBlock(&fmnr, false);
 
+        // Run the IF chain on a single thread
+        ifChain.setFused(true, [](dsp::stream<dsp::complex_t>* out){});
+
         // Initialize audio DSP chain
         afChain.init(&dummyAudioStream);
 
@@ -87,6 +90,9 @@ public:
         afChain.addBlock(&resamp, true);
         afChain.addBlock(&deemp, false);
 
+        // Run the AF chain on a single thread
+        afChain.setFused(true, [](dsp::stream<dsp::stereo_t>* out){});
+
         // Initialize the sink
         srChangeHandler.ctx = this;
         srChangeHandler.handler = sampleRateChangeHandler;
@@ -46,7 +46,7 @@ public:
 
         // Define option lists
         containers.define("WAV", wav::FORMAT_WAV);
-        // containers.define("RF64", wav::FORMAT_RF64); // Disabled for now
+        containers.define("RF64", wav::FORMAT_RF64);
         sampleTypes.define(wav::SAMP_TYPE_UINT8, "Uint8", wav::SAMP_TYPE_UINT8);
         sampleTypes.define(wav::SAMP_TYPE_INT16, "Int16", wav::SAMP_TYPE_INT16);
         sampleTypes.define(wav::SAMP_TYPE_INT32, "Int32", wav::SAMP_TYPE_INT32);
@@ -349,6 +349,12 @@ private:
             else {
                 ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Recording %02d:%02d:%02d", dtm->tm_hour, dtm->tm_min, dtm->tm_sec);
             }
+
+            // Blocks dropped because the disk couldn't keep up
+            size_t dropped = _this->writer.getDroppedBlocks();
+            if (dropped) {
+                ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.0f, 1.0f), "Dropped %zu blocks", dropped);
+            }
         }
     }
 
@@ -4,7 +4,7 @@
 #include <signal_path/signal_path.h>
 #include <signal_path/sink.h>
 #include <portaudio.h>
-#include <dsp/buffer/packer.h>
+#include <dsp/sink/audio_ring.h>
 #include <dsp/convert/stereo_to_mono.h>
 #include <utils/flog.h>
 #include <config.h>
@@ -15,6 +15,7 @@
 
 #define BLOCK_SIZE_DIVIDER 60
 #define AUDIO_LATENCY      1.0 / 60.0
+#define BUFFER_LATENCY     0.02
 
 SDRPP_MOD_INFO{
     /* Name:            */ "new_portaudio_sink",
@@ -51,14 +52,9 @@ public:
         std::string selected = config.conf[_streamName]["device"];
         config.release(true);
 
-        // Register the play state handler
-        playStateHandler.handler = playStateChangeHandler;
-        playStateHandler.ctx = this;
-        gui::mainWindow.onPlayStateChange.bindHandler(&playStateHandler);
-
-        // Initialize DSP blocks
-        packer.init(_stream->sinkOut, 1024);
-        s2m.init(&packer.out);
+        // Initialize DSP blocks, the latency is set once the samplerate is known
+        ring.init(_stream->sinkOut, 960, 4096);
+        monoBuf = dsp::buffer::alloc<dsp::stereo_t>(STREAM_BUFFER_SIZE);
 
         // Refresh devices and select the one from the config
         refreshDevices();
@@ -67,7 +63,7 @@ public:
 
     ~AudioSink() {
         stop();
-        gui::mainWindow.onPlayStateChange.unbindHandler(&playStateHandler);
+        dsp::buffer::free(monoBuf);
     }
 
     void start() {
@@ -75,29 +71,24 @@ public:
 
         // Get device and samplerate
         AudioDevice_t& dev = devices[deviceNames[devId]];
-        double sampleRate = dev.sampleRates[srId];
+        sampleRate = dev.sampleRates[srId];
         int blockSize = sampleRate / BLOCK_SIZE_DIVIDER;
 
         // Set the SDR++ stream sample rate
         _stream->setSampleRate(sampleRate);
 
-        // Update the block size on the packer
-        packer.setSampleCount(blockSize);
-
-        // Clear read stop signals
-        packer.out.clearReadStop();
-        s2m.out.clearReadStop();
+        // Keep half a callback block plus the buffer latency in the ring, with plenty of headroom
+        int targetFill = (blockSize / 2) + (sampleRate * BUFFER_LATENCY);
+        ring.setLatency(targetFill, std::max<int>(targetFill * 4, blockSize * 4));
+        ring.resetCounters();
 
         // Open the stream
         PaError err;
         if (dev.deviceInfo->maxOutputChannels == 1) {
-            packer.start();
-            s2m.start();
             stereo = false;
             err = Pa_OpenStream(&devStream, NULL, &dev.outputParams, sampleRate, blockSize, paNoFlag, _mono_cb, this);
         }
         else {
-            packer.start();
             stereo = true;
             err = Pa_OpenStream(&devStream, NULL, &dev.outputParams, sampleRate, blockSize, paNoFlag, _stereo_cb, this);
         }
@@ -108,6 +99,9 @@ public:
             return;
         }
 
+        // Start DSP
+        ring.start();
+
         flog::info("Starting PortAudio stream at {0} S/s", sampleRate);
 
         // Start stream
@@ -119,20 +113,15 @@ public:
     void stop() {
         if (!running || selectedDevName.empty()) { return; }
 
-        // Send stop signal to the streams
-        packer.out.stopReader();
-        s2m.out.stopReader();
-
-        // Stop DSP
-        packer.stop();
-        s2m.stop();
-
         // Stop stream
         Pa_AbortStream(devStream);
 
         // Close the stream
         Pa_CloseStream(devStream);
 
+        // Stop DSP
+        ring.stop();
+
         running = false;
     }
 
@@ -163,6 +152,13 @@ public:
                 config.release(true);
             }
         }
+
+        // Show the state of the audio buffer
+        if (running) {
+            ImGui::Text("Latency: %.1f ms", (double)ring.getLatency() * 1000.0 / sampleRate);
+            ImGui::Text("Underruns: %llu", (unsigned long long)ring.getUnderruns());
+            ImGui::Text("Overruns: %llu", (unsigned long long)ring.getOverruns());
+        }
     }
 
     int devId = 0;
@@ -170,28 +166,6 @@ public:
     bool stereo = false;
 
 private:
-    static void playStateChangeHandler(bool newState, void* ctx) {
-        AudioSink* _this = (AudioSink*)ctx;
-
-        // Wake up reader to send nulls instead of data in preparation for shutoff
-        if (newState) {
-            if (_this->stereo) {
-                _this->packer.out.stopReader();
-            }
-            else {
-                _this->s2m.out.stopReader();
-            }
-        }
-        else {
-            if (_this->stereo) {
-                _this->packer.out.clearReadStop();
-            }
-            else {
-                _this->s2m.out.clearReadStop();
-            }
-        }
-    }
-
     void refreshDevices() {
         // Clear current list
         devices.clear();
@@ -334,14 +308,13 @@ private:
         // For OSX, mute audio when not playing
         if (!gui::mainWindow.isPlaying()) {
             memset(output, 0, frameCount * sizeof(float));
-            _this->s2m.out.flush();
+            _this->ring.skip(frameCount);
             return 0;
         }
 
-        // Write to buffer
-        _this->s2m.out.read();
-        memcpy(output, _this->s2m.out.readBuf, frameCount * sizeof(float));
-        _this->s2m.out.flush();
+        // Write to buffer, this never waits
+        _this->ring.read(_this->monoBuf, frameCount);
+        _this->s2m.process(frameCount, _this->monoBuf, (float*)output);
         return 0;
     }
 
@@ -352,14 +325,12 @@ private:
         // For OSX, mute audio when not playing
         if (!gui::mainWindow.isPlaying()) {
             memset(output, 0, frameCount * sizeof(dsp::stereo_t));
-            _this->packer.out.flush();
+            _this->ring.skip(frameCount);
             return 0;
         }
 
-        // Write to buffer
-        _this->packer.out.read();
-        memcpy(output, _this->packer.out.readBuf, frameCount * sizeof(dsp::stereo_t));
-        _this->packer.out.flush();
+        // Write to buffer, this never waits
+        _this->ring.read((dsp::stereo_t*)output, frameCount);
         return 0;
     }
 
@@ -374,12 +345,12 @@ private:
     std::string selectedDevName;
 
     SinkManager::Stream* _stream;
-    dsp::buffer::Packer<dsp::stereo_t> packer;
+    dsp::sink::AudioRing<dsp::stereo_t> ring;
     dsp::convert::StereoToMono s2m;
+    dsp::stereo_t* monoBuf;
+    double sampleRate = 48000.0;
 
     PaStream* devStream;
-
-    EventHandler<bool> playStateHandler;
 };
 
 class AudioSinkModule : public ModuleManager::Instance {
@@ -10,8 +10,12 @@
 #include <filesystem>
 #include <regex>
 #include <gui/tuner.h>
+#include <gui/style.h>
+#include <utils/optionlist.h>
 #include <algorithm>
 #include <stdexcept>
+#include <chrono>
+#include <atomic>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -36,6 +40,14 @@ public:
         fileSelect.setPath(config.conf["path"], true);
         config.release();
 
+        // Playback speeds, zero means as fast as the DSP can take the samples
+        speeds.define("1x", 1.0);
+        speeds.define("2x", 2.0);
+        speeds.define("4x", 4.0);
+        speeds.define("8x", 8.0);
+        speeds.define("16x", 16.0);
+        speeds.define("Unlimited", 0.0);
+
         handler.ctx = this;
         handler.selectHandler = menuSelected;
         handler.deselectHandler = menuDeselected;
@@ -92,7 +104,8 @@ private:
         if (_this->running) { return; }
         if (_this->reader == NULL) { return; }
         _this->running = true;
-        _this->workerThread = _this->float32Mode ? std::thread(floatWorker, _this) : std::thread(worker, _this);
+        _this->resetPacing = true;
+        _this->workerThread = std::thread(worker, _this);
         flog::info("FileSourceModule '{0}': Start!", _this->name);
     }
 
@@ -148,36 +161,63 @@ private:
             }
         }
 
-        ImGui::Checkbox("Float32 Mode##_file_source", &_this->float32Mode);
+        // The sample format can't change while samples are being read
+        if (_this->running) { style::beginDisabled(); }
+        ImGui::LeftLabel("Format");
+        ImGui::FillWidth();
+        ImGui::Combo(CONCAT("##_file_source_format_", _this->name), &_this->format, "Auto\0Uint8\0Int8\0Int16\0Float32\0");
+        if (_this->running) { style::endDisabled(); }
+
+        ImGui::LeftLabel("Speed");
+        ImGui::FillWidth();
+        if (ImGui::Combo(CONCAT("##_file_source_speed_", _this->name), &_this->speedId, _this->speeds.txt)) {
+            _this->resetPacing = true;
+        }
+
+        // Timeline scrubber
+        if (_this->reader == NULL) { return; }
+        WavReader::SampleFormat fmt = (WavReader::SampleFormat)_this->format;
+        double duration = (double)_this->reader->getSampleCount(fmt) / _this->sampleRate;
+        float pos = (double)_this->reader->getPosition() / _this->sampleRate;
+        ImGui::FillWidth();
+        if (ImGui::SliderFloat(CONCAT("##_file_source_pos_", _this->name), &pos, 0.0f, duration, formatTime(pos, duration).c_str())) {
+            _this->reader->seek((uint64_t)((double)pos * _this->sampleRate));
+            _this->resetPacing = true;
+        }
     }
 
     static void worker(void* ctx) {
         FileSourceModule* _this = (FileSourceModule*)ctx;
         double sampleRate = std::max(_this->reader->getSampleRate(), (uint32_t)1);
         int blockSize = std::min((int)(sampleRate / 200.0f), (int)STREAM_BUFFER_SIZE);
-        int16_t* inBuf = new int16_t[blockSize * 2];
+        WavReader::SampleFormat fmt = (WavReader::SampleFormat)_this->format;
+        auto next = std::chrono::steady_clock::now();
 
         while (true) {
-            _this->reader->readSamples(inBuf, blockSize * 2 * sizeof(int16_t));
-            volk_16i_s32f_convert_32f((float*)_this->stream.writeBuf, inBuf, 32768.0f, blockSize * 2);
+            _this->reader->readSamples(_this->stream.writeBuf, blockSize, fmt);
             if (!_this->stream.swap(blockSize)) { break; };
-        }
 
-        delete[] inBuf;
-    }
+            // When unlimited, the only limit is how fast the DSP reads from the stream
+            double speed = _this->speeds.value(_this->speedId);
+            if (speed <= 0.0) { continue; }
 
-    static void floatWorker(void* ctx) {
-        FileSourceModule* _this = (FileSourceModule*)ctx;
-        double sampleRate = std::max(_this->reader->getSampleRate(), (uint32_t)1);
-        int blockSize = std::min((int)(sampleRate / 200.0f), (int)STREAM_BUFFER_SIZE);
-        dsp::complex_t* inBuf = new dsp::complex_t[blockSize];
+            // Pace relative to a start point so that timing errors don't accumulate
+            auto now = std::chrono::steady_clock::now();
+            if (_this->resetPacing.exchange(false)) { next = now; }
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>((double)blockSize / (sampleRate * speed)));
 
-        while (true) {
-            _this->reader->readSamples(_this->stream.writeBuf, blockSize * sizeof(dsp::complex_t));
-            if (!_this->stream.swap(blockSize)) { break; };
+            // Don't try to catch up if the DSP fell behind by a lot
+            if (now - next > std::chrono::seconds(1)) { next = now; }
+            std::this_thread::sleep_until(next);
         }
+    }
 
-        delete[] inBuf;
+    static std::string formatTime(double pos, double duration) {
+        char buf[64];
+        int p = pos;
+        int d = duration;
+        sprintf(buf, "%02d:%02d:%02d / %02d:%02d:%02d", p / 3600, (p / 60) % 60, p % 60, d / 3600, (d / 60) % 60, d % 60);
+        return buf;
     }
 
     double getFrequency(std::string filename) {
@@ -201,7 +241,10 @@ private:
 
     double centerFreq = 100000000;
 
-    bool float32Mode = false;
+    int format = WavReader::SAMPLE_FORMAT_AUTO;
+    OptionList<std::string, double> speeds;
+    int speedId = 0;
+    std::atomic<bool> resetPacing = { true };
 };
 
 MOD_EXPORT void _INIT_() {
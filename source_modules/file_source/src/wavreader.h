@@ -1,82 +1,279 @@
-#pragma once
-
 #pragma once
 #include <stdint.h>
 #include <string.h>
-#include <fstream>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <dsp/types.h>
+#include <dsp/convert/sample_format.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
-#define WAV_SIGNATURE       "RIFF"
-#define WAV_TYPE            "WAVE"
-#define WAV_FORMAT_MARK     "fmt "
-#define WAV_DATA_MARK       "data"
-#define WAV_SAMPLE_TYPE_PCM 1
+#define WAV_SIGNATURE           "RIFF"
+#define WAV_SIGNATURE_64        "RF64"
+#define WAV_TYPE                "WAVE"
+#define WAV_FORMAT_MARK         "fmt "
+#define WAV_DS64_MARK           "ds64"
+#define WAV_DATA_MARK           "data"
+#define WAV_SAMPLE_TYPE_PCM     1
+#define WAV_SAMPLE_TYPE_FLOAT   3
 
+// Number of bytes ahead of the read position that the OS is asked to load
+#define WAV_READ_AHEAD          (16 * 1024 * 1024)
+
+// Memory mapped WAV reader with random access. Samples are read as interleaved IQ pairs and
+// the reader wraps around to the start of the data when reaching the end of the file.
 class WavReader {
 public:
+    enum SampleFormat {
+        SAMPLE_FORMAT_AUTO,
+        SAMPLE_FORMAT_UINT8,
+        SAMPLE_FORMAT_INT8,
+        SAMPLE_FORMAT_INT16,
+        SAMPLE_FORMAT_FLOAT32
+    };
+
     WavReader(std::string path) {
-        file = std::ifstream(path.c_str(), std::ios::binary);
-        file.read((char*)&hdr, sizeof(WavHeader_t));
-        valid = false;
-        if (memcmp(hdr.signature, "RIFF", 4) != 0) { return; }
-        if (memcmp(hdr.fileType, "WAVE", 4) != 0) { return; }
-        valid = true;
+        if (!map(path)) { return; }
+        valid = parse();
+        if (!valid) { return; }
+
+#ifndef _WIN32
+        madvise(base, fileSize, MADV_SEQUENTIAL);
+#endif
+    }
+
+    ~WavReader() {
+        close();
     }
 
     uint16_t getBitDepth() {
-        return hdr.bitDepth;
+        return bitDepth;
     }
 
     uint16_t getChannelCount() {
-        return hdr.channelCount;
+        return channelCount;
     }
 
     uint32_t getSampleRate() {
-        return hdr.sampleRate;
+        return sampleRate;
     }
 
     bool isValid() {
         return valid;
     }
 
-    void readSamples(void* data, size_t size) {
-        char* _data = (char*)data;
-        file.read(_data, size);
-        int read = file.gcount();
-        if (read < size) {
-            file.clear();
-            file.seekg(sizeof(WavHeader_t));
-            file.read(&_data[read], size - read);
+    // Total number of IQ samples in the file when read in the given format
+    uint64_t getSampleCount(SampleFormat format = SAMPLE_FORMAT_AUTO) {
+        if (format == SAMPLE_FORMAT_AUTO) { format = autoFormat; }
+        return dataSize / (formatSize(format) * 2);
+    }
+
+    // Index of the next IQ sample to be read
+    uint64_t getPosition() {
+        return position;
+    }
+
+    // Can be called from any thread, takes effect on the next read
+    void seek(uint64_t sample) {
+        position = sample;
+    }
+
+    int readSamples(dsp::complex_t* out, int count, SampleFormat format = SAMPLE_FORMAT_AUTO) {
+        if (!valid) { return 0; }
+        if (format == SAMPLE_FORMAT_AUTO) { format = autoFormat; }
+        int sampleSize = formatSize(format) * 2;
+        uint64_t total = dataSize / sampleSize;
+        if (!total) { return 0; }
+
+        // Read in up to two parts when wrapping around the end of the file
+        int done = 0;
+        while (done < count) {
+            uint64_t pos = position;
+            if (pos >= total) {
+                position.compare_exchange_strong(pos, 0);
+                continue;
+            }
+            uint64_t available = total - pos;
+            int toRead = std::min<uint64_t>(count - done, available);
+            const uint8_t* src = &data[pos * sampleSize];
+            convert(src, &out[done], toRead, format);
+            done += toRead;
+
+            // Expect the next part of the file to be needed
+            uint64_t next = (pos + toRead) * sampleSize;
+            readAhead(next);
+
+            // Only update the position if it wasn't changed by a seek in the meantime
+            uint64_t newPos = (pos + toRead >= total) ? 0 : pos + toRead;
+            position.compare_exchange_strong(pos, newPos);
         }
-        bytesRead += size;
+
+        return done;
     }
 
     void rewind() {
-        file.seekg(sizeof(WavHeader_t));
+        position = 0;
     }
 
     void close() {
-        file.close();
+#ifdef _WIN32
+        if (base) { UnmapViewOfFile(base); }
+        if (mapping) { CloseHandle(mapping); }
+        if (file != INVALID_HANDLE_VALUE) { CloseHandle(file); }
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (base) { munmap(base, fileSize); }
+        if (fd >= 0) { ::close(fd); }
+        fd = -1;
+#endif
+        base = NULL;
+        valid = false;
     }
 
 private:
-    struct WavHeader_t {
-        char signature[4];           // "RIFF"
-        uint32_t fileSize;           // data bytes + sizeof(WavHeader_t) - 8
-        char fileType[4];            // "WAVE"
-        char formatMarker[4];        // "fmt "
-        uint32_t formatHeaderLength; // Always 16
-        uint16_t sampleType;         // PCM (1)
-        uint16_t channelCount;
-        uint32_t sampleRate;
-        uint32_t bytesPerSecond;
-        uint16_t bytesPerSample;
-        uint16_t bitDepth;
-        char dataMarker[4]; // "data"
-        uint32_t dataSize;
-    };
+    bool map(std::string path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) { return false; }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || !size.QuadPart) { return false; }
+        fileSize = size.QuadPart;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping) { return false; }
+        base = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { return false; }
+        struct stat st;
+        if (fstat(fd, &st) || !st.st_size) { return false; }
+        fileSize = st.st_size;
+        void* addr = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) { return false; }
+        base = (uint8_t*)addr;
+#endif
+        return base != NULL;
+    }
+
+    bool parse() {
+        // Check the RIFF header
+        if (fileSize < 12) { return false; }
+        bool rf64 = !memcmp(base, WAV_SIGNATURE_64, 4);
+        if (memcmp(base, WAV_SIGNATURE, 4) && !rf64) { return false; }
+        if (memcmp(&base[8], WAV_TYPE, 4)) { return false; }
+
+        // Walk through the chunks
+        uint64_t ds64DataSize = 0;
+        bool fmtFound = false;
+        uint64_t offset = 12;
+        while (offset + 8 <= fileSize) {
+            const uint8_t* chunk = &base[offset];
+            uint32_t chunkSize;
+            memcpy(&chunkSize, &chunk[4], 4);
+
+            if (!memcmp(chunk, WAV_FORMAT_MARK, 4) && chunkSize >= 16 && offset + 24 <= fileSize) {
+                memcpy(&sampleType, &chunk[8], 2);
+                memcpy(&channelCount, &chunk[10], 2);
+                memcpy(&sampleRate, &chunk[12], 4);
+                memcpy(&bitDepth, &chunk[22], 2);
+                fmtFound = true;
+            }
+            else if (!memcmp(chunk, WAV_DS64_MARK, 4) && chunkSize >= 24 && offset + 32 <= fileSize) {
+                // RF64 files store the real data size here
+                memcpy(&ds64DataSize, &chunk[16], 8);
+            }
+            else if (!memcmp(chunk, WAV_DATA_MARK, 4)) {
+                data = &chunk[8];
+                dataSize = (rf64 && chunkSize == 0xFFFFFFFF) ? ds64DataSize : chunkSize;
+
+                // Files that weren't closed properly have a wrong size, use whatever is there
+                dataSize = std::min<uint64_t>(dataSize ? dataSize : UINT64_MAX, fileSize - (offset + 8));
+                break;
+            }
+
+            // Chunks are padded to an even size
+            offset += 8 + (uint64_t)chunkSize + (chunkSize & 1);
+        }
+        if (!fmtFound || !data) { return false; }
+
+        // Guess the sample format from the header
+        if (sampleType == WAV_SAMPLE_TYPE_FLOAT || bitDepth == 32) {
+            autoFormat = SAMPLE_FORMAT_FLOAT32;
+        }
+        else if (bitDepth == 8) {
+            autoFormat = SAMPLE_FORMAT_UINT8;
+        }
+        else {
+            autoFormat = SAMPLE_FORMAT_INT16;
+        }
+
+        return true;
+    }
+
+    static int formatSize(SampleFormat format) {
+        switch (format) {
+        case SAMPLE_FORMAT_UINT8:
+        case SAMPLE_FORMAT_INT8:
+            return 1;
+        case SAMPLE_FORMAT_FLOAT32:
+            return 4;
+        default:
+            return 2;
+        }
+    }
+
+    void convert(const uint8_t* in, dsp::complex_t* out, int count, SampleFormat format) {
+        switch (format) {
+        case SAMPLE_FORMAT_UINT8:
+            dsp::convert::toComplex(dsp::convert::SAMPLE_FORMAT_U8, in, out, count);
+            break;
+        case SAMPLE_FORMAT_INT8:
+            dsp::convert::toComplex(dsp::convert::SAMPLE_FORMAT_S8, in, out, count);
+            break;
+        case SAMPLE_FORMAT_FLOAT32:
+            dsp::convert::toComplex(dsp::convert::SAMPLE_FORMAT_F32, in, out, count);
+            break;
+        default:
+            dsp::convert::toComplex(dsp::convert::SAMPLE_FORMAT_S16, in, out, count);
+            break;
+        }
+    }
+
+    void readAhead(uint64_t offset) {
+#ifndef _WIN32
+        // madvise needs a page aligned address
+        static const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+        uint64_t start = ((data - base) + offset) & ~(pageSize - 1);
+        if (start >= fileSize) { return; }
+        madvise(&base[start], std::min<uint64_t>(WAV_READ_AHEAD, fileSize - start), MADV_WILLNEED);
+#endif
+    }
 
     bool valid = false;
-    std::ifstream file;
-    size_t bytesRead = 0;
-    WavHeader_t hdr;
-};
\ No newline at end of file
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int fd = -1;
+#endif
+    uint8_t* base = NULL;
+    uint64_t fileSize = 0;
+
+    const uint8_t* data = NULL;
+    uint64_t dataSize = 0;
+    std::atomic<uint64_t> position = { 0 };
+
+    uint16_t sampleType = 0;
+    uint16_t channelCount = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bitDepth = 0;
+    SampleFormat autoFormat = SAMPLE_FORMAT_INT16;
+};
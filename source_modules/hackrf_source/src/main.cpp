@@ -7,6 +7,7 @@
 #include <config.h>
 #include <gui/widgets/stepped_slider.h>
 #include <gui/smgui.h>
+#include <dsp/convert/sample_format.h>
 
 #ifndef __ANDROID__
 #include <libhackrf/hackrf.h>
@@ -383,7 +384,7 @@ private:
 
     static int callback(hackrf_transfer* transfer) {
         HackRFSourceModule* _this = (HackRFSourceModule*)transfer->rx_ctx;
-        volk_8i_s32f_convert_32f((float*)_this->stream.writeBuf, (int8_t*)transfer->buffer, 128.0f, transfer->valid_length);
+        dsp::convert::s8ToComplex((int8_t*)transfer->buffer, _this->stream.writeBuf, transfer->valid_length / 2);
         if (!_this->stream.swap(transfer->valid_length / 2)) { return -1; }
         return 0;
     }
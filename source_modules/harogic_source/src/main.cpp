@@ -5,6 +5,7 @@
 #include <signal_path/signal_path.h>
 #include <core.h>
 #include <utils/optionlist.h>
+#include <dsp/convert/sample_format.h>
 #include <htra_api.h>
 #include <atomic>
 
@@ -408,7 +409,6 @@ private:
 
     void worker() {
         // Allocate sample buffer
-        int realSamps = bufferSize*2;
         IQStream_TypeDef iqs;
 
         // Define number of buffers per swap to maintain 200 fps
@@ -442,10 +442,10 @@ private:
 
             // Convert them to floating point
             if (sampsInt8) {
-                volk_8i_s32f_convert_32f((float*)&stream.writeBuf[(count++)*bufferSize], (int8_t*)iqs.AlternIQStream, 128.0f, realSamps);
+                dsp::convert::s8ToComplex((int8_t*)iqs.AlternIQStream, &stream.writeBuf[(count++)*bufferSize], bufferSize);
             }
             else {
-                volk_16i_s32f_convert_32f((float*)&stream.writeBuf[(count++)*bufferSize], (int16_t*)iqs.AlternIQStream, 32768.0f, realSamps);
+                dsp::convert::s16ToComplex((int16_t*)iqs.AlternIQStream, &stream.writeBuf[(count++)*bufferSize], bufferSize);
             }
 
             // Send them off if we have enough
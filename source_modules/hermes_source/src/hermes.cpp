@@ -1,5 +1,6 @@
 #include "hermes.h"
 #include <utils/flog.h>
+#include <dsp/convert/sample_format.h>
 
 namespace hermes {
     const int SAMPLERATE_LIST[] = {
@@ -89,6 +90,10 @@ namespace hermes {
         }
     }
 
+    uint64_t Client::getDroppedPackets() {
+        return droppedPackets;
+    }
+
     void Client::sendMetisUSB(uint8_t endpoint, void* frame0, void* frame1) {
         // Build packet
         uint32_t seq = usbSeq++;
@@ -163,62 +168,68 @@ namespace hermes {
     }
 
     void Client::worker() {
-        uint8_t rbuf[2048];
-        MetisUSBPacket* pkt = (MetisUSBPacket*)rbuf;
+        uint8_t* rbuf = new uint8_t[HERMES_RECV_BATCH * HERMES_MAX_PACKET_SIZE];
+        int lens[HERMES_RECV_BATCH];
         int sampleCount = 0;
+        bool firstPacket = true;
+        uint32_t lastSeq = 0;
 
         while (true) {
-            // Wait for a packet or exit if connection closed
-            int len = sock->recv(rbuf, 2048);
-            if (len <= 0) { break; }
+            // Wait for packets or exit if connection closed
+            int count = sock->recvBatch(rbuf, lens, HERMES_RECV_BATCH, HERMES_MAX_PACKET_SIZE);
+            if (count <= 0) { break; }
 
-            // Ignore anything that's not a USB packet
-            // TODO: Gotta check the endpoint
-            if (htons(pkt->hdr.signature) != HERMES_METIS_SIGNATURE || pkt->hdr.type != METIS_PKT_USB) {
-                continue;
-            }
-
-            // Parse frames
-            for (int frn = 0; frn < 2; frn++) {
-                uint8_t* frame = pkt->frame[frn];
-                HPSDRUSBHeader* hdr = (HPSDRUSBHeader*)frame;
+            for (int p = 0; p < count; p++) {
+                MetisUSBPacket* pkt = (MetisUSBPacket*)&rbuf[p * HERMES_MAX_PACKET_SIZE];
+                if (lens[p] < sizeof(MetisUSBPacket)) { continue; }
 
-                // Make sure this is a valid frame by checking the sync
-                if (hdr->sync[0] != 0x7F || hdr->sync[1] != 0x7F || hdr->sync[2] != 0x7F) {
+                // Ignore anything that's not a USB packet
+                // TODO: Gotta check the endpoint
+                if (htons(pkt->hdr.signature) != HERMES_METIS_SIGNATURE || pkt->hdr.type != METIS_PKT_USB) {
                     continue;
                 }
 
-                // Check if this is a response
-                if (hdr->c0 & (1 << 7)) {
-                    uint8_t reg = (hdr->c0 >> 1) & 0x3F;
-                    flog::warn("Got response! Reg={0}, Seq={1}", reg, (uint32_t)htonl(pkt->seq));
+                // Count the packets that were lost using the sequence number. Only forward gaps are counted, packets
+                // arriving late are left out and a jump too large to be a loss just resyncs to the new number.
+                uint32_t seq = htonl(pkt->seq);
+                int32_t diff = (int32_t)(seq - lastSeq);
+                bool late = (diff <= 0 && diff >= -HERMES_SEQ_RESYNC_GAP);
+                if (!firstPacket && diff > 1 && diff <= HERMES_SEQ_RESYNC_GAP) { droppedPackets += diff - 1; }
+                if (firstPacket || !late) { lastSeq = seq; }
+                firstPacket = false;
+
+                // Parse frames
+                for (int frn = 0; frn < 2; frn++) {
+                    uint8_t* frame = pkt->frame[frn];
+                    HPSDRUSBHeader* hdr = (HPSDRUSBHeader*)frame;
+
+                    // Make sure this is a valid frame by checking the sync
+                    if (hdr->sync[0] != 0x7F || hdr->sync[1] != 0x7F || hdr->sync[2] != 0x7F) {
+                        continue;
+                    }
+
+                    // Check if this is a response
+                    if (hdr->c0 & (1 << 7)) {
+                        uint8_t reg = (hdr->c0 >> 1) & 0x3F;
+                        flog::warn("Got response! Reg={0}, Seq={1}", reg, (uint32_t)htonl(pkt->seq));
+                    }
+
+                    // Decode and save IQ to buffer, each sample is followed by 16bit of mic audio (IQ swapped for some reason)
+                    dsp::complex_t* writeBuf = &out.writeBuf[sampleCount];
+                    dsp::convert::s24BEToComplex(&frame[8], writeBuf, HERMES_SAMPLES_PER_FRAME, 8, (float)0x1000000);
+                    dsp::convert::swapIQ(writeBuf, HERMES_SAMPLES_PER_FRAME);
+                    sampleCount += HERMES_SAMPLES_PER_FRAME;
+
+                    // If enough samples are in the buffer, send to stream
+                    if (sampleCount >= blockSize) {
+                        out.swap(sampleCount);
+                        sampleCount = 0;
+                    }
                 }
-
-                // Decode and save IQ to buffer
-                uint8_t* iq = &frame[8];
-                dsp::complex_t* writeBuf = &out.writeBuf[sampleCount];
-                for (int i = 0; i < HERMES_SAMPLES_PER_FRAME; i++) {
-                    // Convert to 32bit
-                    int32_t si = ((uint32_t)iq[(i*8) + 0] << 16) | ((uint32_t)iq[(i*8) + 1] << 8) | (uint32_t)iq[(i*8) + 2];
-                    int32_t sq = ((uint32_t)iq[(i*8) + 3] << 16) | ((uint32_t)iq[(i*8) + 4] << 8) | (uint32_t)iq[(i*8) + 5];
-                    
-                    // Sign extend
-                    si = (si << 8) >> 8;
-                    sq = (sq << 8) >> 8;
-
-                    // Convert to float (IQ swapped for some reason)
-                    writeBuf[i].im = (float)si / (float)0x1000000;
-                    writeBuf[i].re = (float)sq / (float)0x1000000;
-                }
-                sampleCount += HERMES_SAMPLES_PER_FRAME;
-
-                // If enough samples are in the buffer, send to stream
-                if (sampleCount >= blockSize) {
-                    out.swap(sampleCount);
-                    sampleCount = 0;
-                }
-            }            
+            }
         }
+
+        delete[] rbuf;
     }
 
     std::vector<Info> discover() {
@@ -290,6 +301,7 @@ namespace hermes {
     std::shared_ptr<Client> open(const net::Address& addr) {
         // Open UDP socket
         auto sock = net::openudp(addr);
+        sock->setRecvBufferSize(NET_UDP_RECV_BUFFER);
 
         // TODO: Check if open successful
         return std::make_shared<Client>(sock);
@@ -6,6 +6,7 @@
 #include <vector>
 #include <string>
 #include <thread>
+#include <atomic>
 
 #define HERMES_METIS_REPEAT         5
 #define HERMES_METIS_TIMEOUT        1000
@@ -14,6 +15,15 @@
 #define HERMES_I2C_DELAY            50
 #define HERMES_SAMPLES_PER_FRAME    63
 
+// Largest UDP packet received from the radio
+#define HERMES_MAX_PACKET_SIZE      2048
+
+// Number of packets received at once
+#define HERMES_RECV_BATCH           32
+
+// Sequence number jumps larger than this are a restart of the stream rather than lost packets
+#define HERMES_SEQ_RESYNC_GAP       4096
+
 namespace hermes {
     enum MetisPacketType {
         METIS_PKT_USB       = 0x01,
@@ -139,6 +149,9 @@ namespace hermes {
         void setGain(int gain);
         void autoFilters(double freq);
 
+        // Number of packets lost on the way, detected by gaps in the sequence number
+        uint64_t getDroppedPackets();
+
         dsp::stream<dsp::complex_t> out;
 
     private:
@@ -160,6 +173,7 @@ namespace hermes {
         std::shared_ptr<net::Socket> sock;
         uint32_t usbSeq = 0;
         uint8_t lastFilt = 0;
+        std::atomic<uint64_t> droppedPackets = { 0 };
 
     };
 
@@ -244,6 +244,16 @@ private:
                 config.release(true);
             }
         }
+
+        // Packets lost between the radio and the PC
+        if (_this->running) {
+            uint64_t dropped = _this->dev->getDroppedPackets();
+            if (dropped) {
+                char buf[128];
+                sprintf(buf, "Dropped %llu packets", (unsigned long long)dropped);
+                SmGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), buf);
+            }
+        }
     }
 
     std::string name;
@@ -5,6 +5,7 @@
 #include <signal_path/signal_path.h>
 #include <core.h>
 #include <utils/optionlist.h>
+#include <dsp/convert/sample_format.h>
 #include "kcsdr.h"
 #include <atomic>
 
@@ -273,7 +274,7 @@ private:
             }
 
             // Convert the samples to float
-            volk_16i_s32f_convert_32f((float*)stream.writeBuf, samps, 8192.0f, count*2);
+            dsp::convert::s16ToComplex(samps, stream.writeBuf, count, 8192.0f);
 
             // Send out the samples
             if (!stream.swap(count)) { break; }
@@ -9,6 +9,7 @@
 #include <gui/smgui.h>
 #include <gui/widgets/stepped_slider.h>
 #include <utils/optionlist.h>
+#include <dsp/convert/sample_format.h>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
@@ -163,8 +164,11 @@ private:
                 _this->sock = net::connect(_this->hostname, _this->port);
             }
             else if (_this->proto == PROTOCOL_UDP) {
-                // Open UDP socket
+                // Open UDP socket, with a large buffer to ride out the times the worker is busy
                 _this->sock = net::openudp("0.0.0.0", _this->port, _this->hostname, _this->port, true);
+                if (!_this->sock->setRecvBufferSize(NET_UDP_RECV_BUFFER)) {
+                    flog::warn("NetworkSourceModule '{0}': Could not enlarge the receive buffer", _this->name);
+                }
             }
         }
         catch (const std::exception& e) {
@@ -173,7 +177,12 @@ private:
         }
 
         // Start receive worker
-        _this->workerThread = std::thread(&NetworkSourceModule::worker, _this);
+        if (_this->proto == PROTOCOL_UDP) {
+            _this->workerThread = std::thread(&NetworkSourceModule::udpWorker, _this);
+        }
+        else {
+            _this->workerThread = std::thread(&NetworkSourceModule::worker, _this);
+        }
 
         _this->running = true;
         flog::info("NetworkSourceModule '{0}': Start!", _this->name);
@@ -271,6 +280,16 @@ private:
         }
 
         if (_this->running) { SmGui::EndDisabled(); }
+
+        // Datagrams that the OS had to drop
+        if (_this->running && _this->proto == PROTOCOL_UDP && _this->sock) {
+            uint64_t dropped = _this->sock->getDropped();
+            if (dropped) {
+                char buf[128];
+                sprintf(buf, "Dropped %llu datagrams", (unsigned long long)dropped);
+                SmGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), buf);
+            }
+        }
     }
 
     void worker() {
@@ -292,22 +311,7 @@ private:
 
             // Convert to CF32 (note: problem if partial sample)
             int count = bytes / sampleSize;
-            switch (sampType) {
-            case SAMPLE_TYPE_INT8:
-                volk_8i_s32f_convert_32f((float*)stream.writeBuf, (int8_t*)buffer, 128.0f, count*2);
-                break;
-            case SAMPLE_TYPE_INT16:
-                volk_16i_s32f_convert_32f((float*)stream.writeBuf, (int16_t*)buffer, 32768.0f, count*2);
-                break;
-            case SAMPLE_TYPE_INT32:
-                volk_32i_s32f_convert_32f((float*)stream.writeBuf, (int32_t*)buffer, 2147483647.0f, count*2);
-                break;
-            case SAMPLE_TYPE_FLOAT32:
-                memcpy(stream.writeBuf, buffer, bytes);
-                break;
-            default:
-                break;
-            }
+            convert(buffer, stream.writeBuf, count);
 
             // Send out converted samples
             if (!stream.swap(count)) { break; }
@@ -317,6 +321,65 @@ private:
         dsp::buffer::free(buffer);
     }
 
+    void udpWorker() {
+        // Compute sizes, a stream buffer is sent out once it holds at least a block
+        int blockSize = samplerate / 200;
+        int sampleSize = SAMPLE_TYPE_SIZE[sampType];
+        const int maxDatagram = 65536;
+
+        // Allocate receive buffers for a whole batch of datagrams
+        uint8_t* buffer = dsp::buffer::alloc<uint8_t>(NET_MAX_BATCH_SIZE * maxDatagram);
+        int lens[NET_MAX_BATCH_SIZE];
+        int count = 0;
+
+        while (true) {
+            // Receive all datagrams that are waiting
+            int n = sock->recvBatch(buffer, lens, NET_MAX_BATCH_SIZE, maxDatagram);
+            if (n <= 0) { break; }
+
+            // Convert all of them into the same stream buffer
+            bool ok = true;
+            for (int i = 0; i < n; i++) {
+                int samples = lens[i] / sampleSize;
+                if (count + samples > STREAM_BUFFER_SIZE) {
+                    if (!(ok = stream.swap(count))) { break; }
+                    count = 0;
+                }
+                convert(&buffer[i * maxDatagram], &stream.writeBuf[count], samples);
+                count += samples;
+            }
+            if (!ok) { break; }
+
+            // Send out converted samples
+            if (count >= blockSize) {
+                if (!stream.swap(count)) { break; }
+                count = 0;
+            }
+        }
+
+        // Free receive buffer
+        dsp::buffer::free(buffer);
+    }
+
+    void convert(const uint8_t* in, dsp::complex_t* out, int count) {
+        switch (sampType) {
+        case SAMPLE_TYPE_INT8:
+            dsp::convert::toComplex(dsp::convert::SAMPLE_FORMAT_S8, in, out, count);
+            break;
+        case SAMPLE_TYPE_INT16:
+            dsp::convert::toComplex(dsp::convert::SAMPLE_FORMAT_S16, in, out, count);
+            break;
+        case SAMPLE_TYPE_INT32:
+            dsp::convert::toComplex(dsp::convert::SAMPLE_FORMAT_S32, in, out, count);
+            break;
+        case SAMPLE_TYPE_FLOAT32:
+            dsp::convert::toComplex(dsp::convert::SAMPLE_FORMAT_F32, in, out, count);
+            break;
+        default:
+            break;
+        }
+    }
+
     std::string name;
     bool enabled = true;
     dsp::stream<dsp::complex_t> stream;
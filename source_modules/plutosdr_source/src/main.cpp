@@ -5,6 +5,7 @@
 #include <core.h>
 #include <gui/style.h>
 #include <gui/smgui.h>
+#include <dsp/convert/sample_format.h>
 #include <iio.h>
 #include <ad9361.h>
 #include <utils/optionlist.h>
@@ -477,7 +478,7 @@ private:
             if (!buf) { break; }
 
             // Convert samples to CF32
-            volk_16i_s32f_convert_32f((float*)_this->stream.writeBuf, buf, 32768.0f, blockSize * 2);
+            dsp::convert::s16ToComplex(buf, _this->stream.writeBuf, blockSize);
 
             // Send out the samples
             if (!_this->stream.swap(blockSize)) { break; };
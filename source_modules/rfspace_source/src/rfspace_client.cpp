@@ -1,5 +1,5 @@
 #include <rfspace_client.h>
-#include <volk/volk.h>
+#include <dsp/convert/sample_format.h>
 #include <cstring>
 #include <utils/flog.h>
 
@@ -238,7 +238,7 @@ namespace rfspace {
                 // Convert samples to complex float
                 int16_t* samples = (int16_t*)&buffer[4];
                 int sampCount = (size - 4) / (2 * sizeof(int16_t));
-                volk_16i_s32f_convert_32f((float*)&output->writeBuf[inBuffer], samples, 32768.0f, sampCount * 2);
+                dsp::convert::s16ToComplex(samples, &output->writeBuf[inBuffer], sampCount);
                 inBuffer += sampCount;
 
                 // Send out samples if enough are buffered
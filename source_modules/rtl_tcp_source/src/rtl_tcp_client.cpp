@@ -82,10 +82,7 @@ namespace rtltcp {
 
             // Convert to complex float
             int scount = count/2;
-            for (int i = 0; i < scount; i++) {
-                stream->writeBuf[i].re = ((double)buffer[i * 2] - 128.0) / 128.0;
-                stream->writeBuf[i].im = ((double)buffer[(i * 2) + 1] - 128.0) / 128.0;
-            }
+            dsp::convert::u8ToComplex(buffer, stream->writeBuf, scount);
 
             // Swap buffer
             if (!stream->swap(scount)) { break; }
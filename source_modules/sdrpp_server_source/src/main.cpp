@@ -36,6 +36,10 @@ public:
         sampleTypeList.define("Int16", dsp::compression::PCM_TYPE_I16);
         sampleTypeList.define("Float32", dsp::compression::PCM_TYPE_F32);
         sampleTypeId = sampleTypeList.valueId(dsp::compression::PCM_TYPE_I16);
+        for (double sr : { 48000.0, 96000.0, 192000.0, 250000.0, 500000.0, 1000000.0, 2000000.0 }) {
+            channelRateList.define(getBandwdithScaled(sr), sr);
+        }
+        channelRateId = channelRateList.valueId(250000.0);
 
         handler.ctx = this;
         handler.selectHandler = menuSelected;
@@ -116,7 +120,7 @@ private:
         }
 
         // Set configuration
-        _this->client->setFrequency(_this->freq);
+        _this->applyTuning();
         _this->client->start();
 
         _this->running = true;
@@ -135,10 +139,10 @@ private:
 
     static void tune(double freq, void* ctx) {
         SDRPPServerSourceModule* _this = (SDRPPServerSourceModule*)ctx;
+        _this->freq = freq;
         if (_this->running && _this->connected()) {
-            _this->client->setFrequency(freq);
+            _this->applyTuning();
         }
-        _this->freq = freq;
         flog::info("SDRPPServerSourceModule '{0}': Tune: {1}!", _this->name, freq);
     }
 
@@ -191,30 +195,64 @@ private:
             }
             
             if (ImGui::Checkbox("Compression", &_this->compression)) {
-                _this->client->setCompression(_this->compression);
+                _this->client->setCompression(_this->compression, _this->compressionLevel);
 
                 // Save config
                 config.acquire();
                 config.conf["servers"][_this->devConfName]["compression"] = _this->compression;
                 config.release(true);
             }
+            if (_this->compression) {
+                ImGui::LeftLabel("Level");
+                ImGui::FillWidth();
+                if (ImGui::SliderInt("##sdrpp_srv_source_comp_level", &_this->compressionLevel, 1, 19)) {
+                    _this->client->setCompression(_this->compression, _this->compressionLevel);
+
+                    // Save config
+                    config.acquire();
+                    config.conf["servers"][_this->devConfName]["compressionLevel"] = _this->compressionLevel;
+                    config.release(true);
+                }
+            }
 
-            bool dummy = true;
-            style::beginDisabled();
-            ImGui::Checkbox("Full IQ", &dummy);
-            style::endDisabled();
+            // Without full IQ, the server only sends a channel around the tuned frequency
+            if (ImGui::Checkbox("Full IQ", &_this->fullIQ)) {
+                _this->applyChannel();
+
+                // Save config
+                config.acquire();
+                config.conf["servers"][_this->devConfName]["fullIQ"] = _this->fullIQ;
+                config.release(true);
+            }
+            if (!_this->fullIQ) {
+                ImGui::LeftLabel("Channel rate");
+                ImGui::FillWidth();
+                if (ImGui::Combo("##sdrpp_srv_source_chan_rate", &_this->channelRateId, _this->channelRateList.txt)) {
+                    _this->applyChannel();
+
+                    // Save config
+                    config.acquire();
+                    config.conf["servers"][_this->devConfName]["channelRate"] = _this->channelRateList.key(_this->channelRateId);
+                    config.release(true);
+                }
+            }
 
             // Calculate datarate
             _this->frametimeCounter += ImGui::GetIO().DeltaTime;
             if (_this->frametimeCounter >= 0.2f) {
                 _this->datarate = ((float)_this->client->bytes / (_this->frametimeCounter * 1024.0f * 1024.0f)) * 8;
+                _this->ratio = _this->client->bytes ? (float)_this->client->rawBytes / (float)_this->client->bytes : 0.0f;
                 _this->frametimeCounter = 0;
                 _this->client->bytes = 0;
+                _this->client->rawBytes = 0;
             }
 
             ImGui::TextUnformatted("Status:");
             ImGui::SameLine();
             ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Connected (%.3f Mbit/s)", _this->datarate);
+            if (_this->compression) {
+                ImGui::Text("Compression ratio: %.2f", _this->ratio);
+            }
 
             ImGui::CollapsingHeader("Source [REMOTE]", ImGuiTreeNodeFlags_DefaultOpen);
 
@@ -231,6 +269,22 @@ private:
         return client && client->isOpen();
     }
 
+    void applyTuning() {
+        // In channel mode, the server only retunes if the channel leaves its baseband
+        if (fullIQ) {
+            client->setFrequency(freq);
+        }
+        else {
+            applyChannel();
+        }
+    }
+
+    void applyChannel() {
+        if (!connected()) { return; }
+        double samplerate = fullIQ ? 0.0 : channelRateList.value(channelRateId);
+        client->setChannel(freq, samplerate, samplerate);
+    }
+
     void tryConnect() {
         try {
             if (client) { client.reset(); }
@@ -258,10 +312,24 @@ private:
         if (config.conf["servers"][devConfName].contains("compression")) {
             compression = config.conf["servers"][devConfName]["compression"];
         }
+        compressionLevel = 1;
+        if (config.conf["servers"][devConfName].contains("compressionLevel")) {
+            compressionLevel = config.conf["servers"][devConfName]["compressionLevel"];
+        }
+        fullIQ = true;
+        if (config.conf["servers"][devConfName].contains("fullIQ")) {
+            fullIQ = config.conf["servers"][devConfName]["fullIQ"];
+        }
+        channelRateId = channelRateList.valueId(250000.0);
+        if (config.conf["servers"][devConfName].contains("channelRate")) {
+            std::string key = config.conf["servers"][devConfName]["channelRate"];
+            if (channelRateList.keyExists(key)) { channelRateId = channelRateList.keyId(key); }
+        }
 
         // Set settings
         client->setSampleType(sampleTypeList[sampleTypeId]);
-        client->setCompression(compression);
+        client->setCompression(compression, compressionLevel);
+        applyChannel();
     }
 
     std::string name;
@@ -272,6 +340,7 @@ private:
     bool serverBusy = false;
 
     float datarate = 0;
+    float ratio = 0;
     float frametimeCounter = 0;
 
     char hostname[1024];
@@ -284,6 +353,11 @@ private:
     OptionList<std::string, dsp::compression::PCMType> sampleTypeList;
     int sampleTypeId;
     bool compression = false;
+    int compressionLevel = 1;
+
+    OptionList<std::string, double> channelRateList;
+    int channelRateId;
+    bool fullIQ = true;
 
     std::shared_ptr<server::Client> client;
 };
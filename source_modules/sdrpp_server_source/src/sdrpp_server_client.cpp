@@ -127,10 +127,26 @@ namespace server {
         sendCommand(COMMAND_SET_SAMPLE_TYPE, 1);
     }
 
-    void Client::setCompression(bool enabled) {
+    void Client::setCompression(bool enabled, int level) {
         if (!isOpen()) { return; }
-         s_cmd_data[0] = enabled;
-        sendCommand(COMMAND_SET_COMPRESSION, 1);
+        s_cmd_data[0] = enabled;
+
+        // Only send the level when needed so that servers without it still accept the command
+        if (level == SERVER_DEFAULT_COMPRESSION_LEVEL) {
+            sendCommand(COMMAND_SET_COMPRESSION, 1);
+            return;
+        }
+        s_cmd_data[1] = level;
+        sendCommand(COMMAND_SET_COMPRESSION, 2);
+    }
+
+    void Client::setChannel(double freq, double samplerate, double bandwidth) {
+        if (!isOpen()) { return; }
+        ChannelRequest* req = (ChannelRequest*)s_cmd_data;
+        req->frequency = freq;
+        req->samplerate = samplerate;
+        req->bandwidth = bandwidth;
+        sendCommand(COMMAND_SET_CHANNEL, sizeof(ChannelRequest));
     }
 
     void Client::start() {
@@ -218,10 +234,12 @@ namespace server {
             }
             else if (r_pkt_hdr->type == PACKET_TYPE_BASEBAND) {
                 memcpy(decompIn.writeBuf, &rbuffer[sizeof(PacketHeader)], r_pkt_hdr->size - sizeof(PacketHeader));
+                rawBytes += r_pkt_hdr->size;
                 if (!decompIn.swap(r_pkt_hdr->size - sizeof(PacketHeader))) { break; }
             }
             else if (r_pkt_hdr->type == PACKET_TYPE_BASEBAND_COMPRESSED) {
                 size_t outCount = ZSTD_decompressDCtx(dctx, decompIn.writeBuf, STREAM_BUFFER_SIZE*sizeof(dsp::complex_t)+8, r_pkt_data, r_pkt_hdr->size - sizeof(PacketHeader));
+                rawBytes += sizeof(PacketHeader) + outCount;
                 if (outCount) {
                     if (!decompIn.swap(outCount)) { break; }
                 };
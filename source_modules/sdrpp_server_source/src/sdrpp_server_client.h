@@ -88,7 +88,10 @@ namespace server {
         double getSampleRate();
         
         void setSampleType(dsp::compression::PCMType type);
-        void setCompression(bool enabled);
+        void setCompression(bool enabled, int level = SERVER_DEFAULT_COMPRESSION_LEVEL);
+
+        // Ask for a channel of the baseband instead of all of it, a samplerate of zero selects the full baseband
+        void setChannel(double freq, double samplerate, double bandwidth);
 
         void start();
         void stop();
@@ -97,6 +100,7 @@ namespace server {
         bool isOpen();
 
         int bytes = 0;
+        int rawBytes = 0;
         bool serverBusy = false;
 
     private: